@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "EvaluationCache.h"
+#include "Evaluator.h"
+#include "Game.h"
+
+// Runs many jobs, typically whole self-play games, as coroutines on a few threads and evaluates
+// what they ask for together. A job suspends at co_await evaluate(positions); once every job has
+// either finished or suspended, the scheduler evaluates the positions of all waiting jobs with one
+// evaluateBatch call (split at max_batch, and with a position asked for twice evaluated once) and
+// resumes them with their results. The network thus sees batches as wide as the number of jobs
+// times the leaves each search collects, however many threads run the tree work.
+//
+// Jobs are resumed in parallel on up to num_threads OpenMP threads, so what they share must be
+// thread-safe, as MCTSLearn and EvaluationCache are. The evaluator is only called from the thread
+// that calls run().
+template<Game G>
+class BatchScheduler {
+public:
+    // Return type of a job. Jobs start suspended and run once spawned and the scheduler runs.
+    class Task {
+    public:
+        struct promise_type {
+            std::exception_ptr exception;
+
+            Task get_return_object() {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept {
+                return {};
+            }
+
+            std::suspend_always final_suspend() noexcept {
+                return {};
+            }
+
+            void return_void() {}
+
+            void unhandled_exception() {
+                exception = std::current_exception();
+            }
+        };
+
+        Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+        Task(const Task &) = delete;
+
+        Task &operator=(const Task &) = delete;
+
+        ~Task() {
+            if (handle) {
+                handle.destroy();
+            }
+        }
+
+    private:
+        friend class BatchScheduler;
+
+        std::coroutine_handle<promise_type> handle;
+
+        explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    };
+
+private:
+    struct Request {
+        const std::vector<G> *positions;
+        std::vector<Evaluation> evaluations;
+        std::coroutine_handle<> waiting;
+    };
+
+public:
+    // What evaluate() returns for the job to co_await. Lives in the job's frame while it waits.
+    class Evaluate {
+    private:
+        BatchScheduler &scheduler;
+        Request request;
+
+    public:
+        Evaluate(BatchScheduler &scheduler, const std::vector<G> &positions)
+                : scheduler(scheduler), request{&positions, {}, nullptr} {}
+
+        // Nothing to evaluate, nothing to wait for.
+        [[nodiscard]] bool await_ready() const noexcept {
+            return request.positions->empty();
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) {
+            request.waiting = handle;
+            std::lock_guard<std::mutex> guard(scheduler.lock);
+            scheduler.pending.push_back(&request);
+        }
+
+        std::vector<Evaluation> await_resume() {
+            return std::move(request.evaluations);
+        }
+    };
+
+private:
+    Evaluator<G> &evaluator;
+    size_t max_batch;
+    std::vector<Task> tasks;
+    std::mutex lock;
+    std::vector<Request *> pending;
+    size_t forward_count = 0;
+    size_t evaluated_count = 0;
+
+    // Answers every pending request and appends the jobs to resume to ready.
+    void evaluatePending(std::vector<std::coroutine_handle<>> &ready) {
+        std::vector<G> batch;
+        std::vector<size_t> slots;
+        // Zobrist keys can collide, so a key only shares an evaluation with an equal position.
+        std::unordered_multimap<uint64_t, size_t> index;
+        for (const Request *request: pending) {
+            for (const G &position: *request->positions) {
+                const uint64_t key = position.getKey();
+                auto [first, last] = index.equal_range(key);
+                auto same = std::find_if(first, last, [&](const auto &entry) {
+                    return batch[entry.second] == position;
+                });
+                if (same != last) {
+                    slots.push_back(same->second);
+                } else {
+                    index.emplace(key, batch.size());
+                    slots.push_back(batch.size());
+                    batch.push_back(position);
+                }
+            }
+        }
+
+        std::vector<Evaluation> evaluations;
+        evaluations.reserve(batch.size());
+        for (size_t begin = 0; begin < batch.size(); begin += max_batch) {
+            const size_t end = std::min(batch.size(), begin + max_batch);
+            std::vector<G> chunk(batch.begin() + begin, batch.begin() + end);
+            std::vector<Evaluation> results = evaluator.evaluateBatch(chunk);
+            std::move(results.begin(), results.end(), std::back_inserter(evaluations));
+            ++forward_count;
+        }
+        evaluated_count += batch.size();
+
+        size_t next = 0;
+        for (Request *request: pending) {
+            request->evaluations.clear();
+            for (size_t i = 0; i < request->positions->size(); ++i) {
+                request->evaluations.push_back(evaluations[slots[next++]]);
+            }
+            ready.push_back(request->waiting);
+        }
+        pending.clear();
+    }
+
+public:
+    explicit BatchScheduler(Evaluator<G> &evaluator, size_t max_batch = 1024)
+            : evaluator(evaluator), max_batch(max_batch) {
+        if (max_batch == 0) {
+            throw std::invalid_argument("Scheduler batch size must be at least 1");
+        }
+    }
+
+    BatchScheduler(const BatchScheduler &) = delete;
+
+    BatchScheduler &operator=(const BatchScheduler &) = delete;
+
+    // Suspends the calling job until the next batched evaluation has evaluated positions, which
+    // must stay alive and unchanged until then.
+    Evaluate evaluate(const std::vector<G> &positions) {
+        return Evaluate(*this, positions);
+    }
+
+    // The evaluator's cache, for jobs to skip positions that were already evaluated.
+    [[nodiscard]] EvaluationCache<G> *cache() const {
+        return evaluator.cache();
+    }
+
+    // The evaluator itself, for jobs to read the evaluations it holds in memory without a round.
+    [[nodiscard]] const Evaluator<G> &backend() const {
+        return evaluator;
+    }
+
+    void spawn(Task task) {
+        tasks.push_back(std::move(task));
+    }
+
+    // Runs every spawned job to completion. The first exception a job throws is rethrown here, once
+    // the round it was thrown in is over, and the remaining jobs are dropped.
+    void run(size_t num_threads) {
+        std::vector<std::coroutine_handle<>> ready;
+        for (const Task &task: tasks) {
+            ready.push_back(task.handle);
+        }
+        while (!ready.empty()) {
+#pragma omp parallel for schedule(dynamic) num_threads(static_cast<int>(std::max<size_t>(1, num_threads)))
+            for (size_t i = 0; i < ready.size(); ++i) {
+                ready[i].resume();
+            }
+            ready.clear();
+            for (const Task &task: tasks) {
+                if (task.handle.done() && task.handle.promise().exception) {
+                    std::exception_ptr exception = task.handle.promise().exception;
+                    pending.clear();
+                    tasks.clear();
+                    std::rethrow_exception(exception);
+                }
+            }
+            evaluatePending(ready);
+        }
+        tasks.clear();
+    }
+
+    // Batched evaluateBatch calls made so far, and the distinct positions they evaluated.
+    [[nodiscard]] size_t forwards() const {
+        return forward_count;
+    }
+
+    [[nodiscard]] size_t evaluated() const {
+        return evaluated_count;
+    }
+};
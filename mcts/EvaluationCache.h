@@ -0,0 +1,170 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "Evaluator.h"
+
+// Fixed-capacity map from position keys to network evaluations, shared by every search, game and
+// thread that evaluates with the same weights. Entries are spread over independently locked shards,
+// each an array of WAYS-entry sets: a key can live in any entry of its set, and a new key takes an
+// empty or outdated entry of the set when there is one and evicts one of the others otherwise.
+//
+// Every entry is tagged with the generation it was stored in. invalidate() starts a new generation,
+// which turns all older entries into misses without touching them, so a weight update costs nothing
+// here.
+template<Game G>
+class EvaluationCache {
+public:
+    static constexpr size_t SHARDS = 16;
+    static constexpr size_t POLICY_SIZE = G::ACTION_SIZE;
+    static constexpr size_t WAYS = 4;
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t generation = 0;  // 0 marks an empty slot
+        float value = 0.0f;
+        std::array<float, POLICY_SIZE> policy{};
+    };
+
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::vector<Entry> entries;
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t set_mask;
+    std::atomic<uint32_t> current_generation{1};
+
+    static uint64_t mix(uint64_t key) {
+        return key * 0x9E3779B97F4A7C15ull;
+    }
+
+    Shard &shardOf(uint64_t hash) const {
+        return shards[hash >> 60 & (SHARDS - 1)];
+    }
+
+public:
+    // Room for at least capacity entries, rounded up to a power of two of sets per shard.
+    explicit EvaluationCache(size_t capacity) : shards(std::make_unique<Shard[]>(SHARDS)) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Evaluation cache capacity must be at least 1");
+        }
+        size_t sets = 1;
+        while (sets * WAYS * SHARDS < capacity) {
+            sets *= 2;
+        }
+        set_mask = sets - 1;
+        for (size_t i = 0; i < SHARDS; ++i) {
+            shards[i].entries.resize(sets * WAYS);
+        }
+    }
+
+    EvaluationCache(const EvaluationCache &) = delete;
+
+    EvaluationCache &operator=(const EvaluationCache &) = delete;
+
+    // Copies the evaluation stored for key in the current generation into evaluation.
+    bool find(uint64_t key, Evaluation &evaluation) {
+        const uint64_t hash = mix(key);
+        Shard &shard = shardOf(hash);
+        const uint32_t current = generation();
+        std::lock_guard<std::mutex> guard(shard.lock);
+        const Entry *set = &shard.entries[(hash >> 32 & set_mask) * WAYS];
+        for (size_t way = 0; way < WAYS; ++way) {
+            if (set[way].key == key && set[way].generation == current) {
+                ++shard.hits;
+                evaluation.policy.assign(set[way].policy.begin(), set[way].policy.end());
+                evaluation.value = set[way].value;
+                return true;
+            }
+        }
+        ++shard.misses;
+        return false;
+    }
+
+    void store(uint64_t key, const Evaluation &evaluation) {
+        if (evaluation.policy.size() != POLICY_SIZE) {
+            throw std::invalid_argument("Evaluation cache expects policies of " + std::to_string(POLICY_SIZE) +
+                                        " actions");
+        }
+        const uint64_t hash = mix(key);
+        Shard &shard = shardOf(hash);
+        const uint32_t current = generation();
+        std::lock_guard<std::mutex> guard(shard.lock);
+        Entry *set = &shard.entries[(hash >> 32 & set_mask) * WAYS];
+        // Without a free entry the victim is picked by hash bits the set index does not use.
+        Entry *entry = &set[hash >> 56 & (WAYS - 1)];
+        Entry *outdated = nullptr;
+        for (size_t way = 0; way < WAYS; ++way) {
+            if (set[way].key == key && set[way].generation == current) {
+                outdated = nullptr;
+                entry = &set[way];
+                break;
+            }
+            if (!outdated && set[way].generation != current) {
+                outdated = &set[way];
+            }
+        }
+        entry = outdated ? outdated : entry;
+        entry->key = key;
+        entry->generation = current;
+        entry->value = evaluation.value;
+        std::copy(evaluation.policy.begin(), evaluation.policy.end(), entry->policy.begin());
+    }
+
+    // Starts a new generation; call whenever the weights behind the cached evaluations change.
+    void invalidate() {
+        uint32_t next = current_generation.load(std::memory_order_relaxed) + 1;
+        current_generation.store(next == 0 ? 1 : next, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint32_t generation() const {
+        return current_generation.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] size_t capacity() const {
+        return SHARDS * (set_mask + 1) * WAYS;
+    }
+
+    [[nodiscard]] size_t hits() const {
+        size_t total = 0;
+        for (size_t i = 0; i < SHARDS; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            total += shards[i].hits;
+        }
+        return total;
+    }
+
+    [[nodiscard]] size_t misses() const {
+        size_t total = 0;
+        for (size_t i = 0; i < SHARDS; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            total += shards[i].misses;
+        }
+        return total;
+    }
+
+    [[nodiscard]] float hitRate() const {
+        size_t found = hits();
+        size_t lookups = found + misses();
+        return lookups == 0 ? 0.0f : static_cast<float>(found) / static_cast<float>(lookups);
+    }
+
+    void resetCounters() {
+        for (size_t i = 0; i < SHARDS; ++i) {
+            std::lock_guard<std::mutex> guard(shards[i].lock);
+            shards[i].hits = 0;
+            shards[i].misses = 0;
+        }
+    }
+};
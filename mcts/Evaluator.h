@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Game.h"
+#include "ResNet.h"
+#include "TicTacToe.h"
+#include "TicTacToeModel.h"
+
+// Network output for one position: a probability for every action (illegal ones included, the
+// search masks them) and the expected outcome in [-1, 1] for the player to move.
+struct Evaluation {
+    std::vector<float> policy;
+    float value = 0.0f;
+};
+
+// An evaluation read in place from memory the evaluator owns: policy points at its ACTION_SIZE
+// probabilities and stays valid until the evaluator changes.
+struct EvaluationView {
+    const float *policy = nullptr;
+    float value = 0.0f;
+};
+
+template<Game G>
+class EvaluationCache;
+
+// What MCTS asks of a network. Backends decide where and how the model runs.
+template<Game G>
+class Evaluator {
+private:
+    EvaluationCache<G> *evaluation_cache = nullptr;
+
+public:
+    virtual ~Evaluator() = default;
+
+    // The search looks positions up in cache before evaluating them and stores what it evaluates.
+    // The cache must only hold evaluations of the weights this evaluator runs.
+    void setCache(EvaluationCache<G> *cache) {
+        evaluation_cache = cache;
+    }
+
+    [[nodiscard]] EvaluationCache<G> *cache() const {
+        return evaluation_cache;
+    }
+
+    virtual Evaluation evaluate(const G &game) = 0;
+
+    // Backends that already hold the evaluation of game in memory, such as a table filled ahead of
+    // time, hand it out here without copying or allocating. False when game has to go through
+    // evaluate().
+    virtual bool lookup(const G &, EvaluationView &) const {
+        return false;
+    }
+
+    // Evaluates several positions at once. Backends that can run them as one batch override this.
+    virtual std::vector<Evaluation> evaluateBatch(const std::vector<G> &games) {
+        std::vector<Evaluation> evaluations;
+        evaluations.reserve(games.size());
+        for (const auto &game: games) {
+            evaluations.push_back(evaluate(game));
+        }
+        return evaluations;
+    }
+};
+
+// Evaluates positions batch_size at a time and hands consume the index of each batch's first
+// position, the batch and its evaluations, after checking that every policy covers G's actions.
+template<Game G, typename Consume>
+void evaluateInBatches(Evaluator<G> &evaluator, const std::vector<G> &positions, size_t batch_size,
+                       Consume &&consume) {
+    for (size_t begin = 0; begin < positions.size(); begin += batch_size) {
+        const std::vector<G> batch(positions.begin() + begin,
+                                   positions.begin() + std::min(positions.size(), begin + batch_size));
+        const std::vector<Evaluation> evaluations = evaluator.evaluateBatch(batch);
+        if (evaluations.size() != batch.size()) {
+            throw std::invalid_argument("Evaluator returned " + std::to_string(evaluations.size()) +
+                                        " evaluations for " + std::to_string(batch.size()) + " positions");
+        }
+        for (const Evaluation &evaluation: evaluations) {
+            if (evaluation.policy.size() != G::ACTION_SIZE) {
+                throw std::invalid_argument("Evaluations need a policy over all " +
+                                            std::to_string(G::ACTION_SIZE) + " actions");
+            }
+        }
+        consume(begin, batch, evaluations);
+    }
+}
+
+// Models whose policy head ends in a linear layer rather than a softmax.
+template<typename Model>
+constexpr bool policy_is_logits = std::is_same_v<Model, nnm::ResNet>;
+
+// Runs an nnm model in the calling thread. Inference is a few small GEMMs on a 3x3 board, so a
+// leaf costs microseconds; the model is only read, so one instance can serve several searches.
+template<typename Model, Game G = TicTacToe>
+class NnmEvaluator final : public Evaluator<G> {
+private:
+    Model &model;
+    nnm::SoftMaxLayer softmax{1};
+
+public:
+    explicit NnmEvaluator(Model &model) : model(model) {}
+
+    Evaluation evaluate(const G &game) override {
+        auto [policy, value] = model.forward(game.getEncodedState());
+        if constexpr (policy_is_logits<Model>) {
+            policy = softmax.forward(std::move(policy));
+        }
+        return {std::move(policy.getData()), value(0, 0, 0, 0)};
+    }
+
+    // One forward over an (N, C, H, W) batch, so the GEMMs see N rows instead of one. Positions are
+    // encoded straight into the batch.
+    std::vector<Evaluation> evaluateBatch(const std::vector<G> &games) override {
+        if (games.empty()) {
+            return {};
+        }
+        nnm::Tensor4D batch(games.size(), G::PLANES, G::HEIGHT, G::WIDTH);
+        encodeBatch(games.data(), games.size(), batch.getData().data());
+
+        auto [policy, value] = model.forward(batch);
+        if constexpr (policy_is_logits<Model>) {
+            policy = softmax.forward(std::move(policy));
+        }
+        const size_t actions = policy.getChannels();
+        std::vector<Evaluation> evaluations(games.size());
+        for (size_t i = 0; i < games.size(); ++i) {
+            auto row = policy.getData().begin() + i * actions;
+            evaluations[i] = {std::vector<float>(row, row + actions), value(i, 0, 0, 0)};
+        }
+        return evaluations;
+    }
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include "Tensor4D.h"
+
+// What the search and the training loop need from a game. Positions are small values that are
+// copied freely; moves are uint8_t action indices below ACTION_SIZE, which also sizes the policy,
+// and no game lasts more than MAX_GAME_LENGTH moves. getKey() must tell positions apart (exactly,
+// or as a Zobrist hash) because transpositions and the evaluation cache are keyed on it. Where a
+// wrong match would hand one game's evaluation to another, as in the batch scheduler, keys that
+// match are confirmed with operator==.
+//
+// The network input is PLANES planes of HEIGHT x WIDTH values. encode() writes all of them,
+// channel-major, to the buffer it is given, and getEncodedState() returns them as a (1, PLANES,
+// HEIGHT, WIDTH) tensor.
+template<typename G>
+concept Game = std::copy_constructible<G> && requires(G game, const G &position, uint8_t move) {
+    requires std::same_as<std::remove_cv_t<decltype(G::ACTION_SIZE)>, size_t>;
+    requires std::same_as<std::remove_cv_t<decltype(G::MAX_GAME_LENGTH)>, size_t>;
+    requires G::ACTION_SIZE < 256;
+    requires std::same_as<std::remove_cv_t<decltype(G::PLANES)>, size_t>;
+    requires std::same_as<std::remove_cv_t<decltype(G::HEIGHT)>, size_t>;
+    requires std::same_as<std::remove_cv_t<decltype(G::WIDTH)>, size_t>;
+    G();
+    { position.getLegalMoves() } -> std::same_as<std::array<uint8_t, G::ACTION_SIZE>>;
+    { position.CountLegalMoves() } -> std::convertible_to<int>;
+    game.makeMove(move);
+    position.encode(static_cast<float *>(nullptr));
+    { position.getEncodedState() } -> std::same_as<nnm::Tensor4D>;
+    // The result for the player who made the last move, and whether the game is over.
+    { position.getValueAndTerminated() } -> std::same_as<std::pair<float, bool>>;
+    { position.isRunning() } -> std::same_as<bool>;
+    { position.getKey() } -> std::same_as<uint64_t>;
+    { position == position } -> std::convertible_to<bool>;
+};
+
+// Games whose positions come in symmetric forms that evaluate alike. getCanonical() returns the
+// form every symmetric position shares and the symmetry that leads there; a move m of the position
+// is move transformMove(m, symmetry) in that form.
+template<typename G>
+concept SymmetricGame = Game<G> && requires(const G &position, uint8_t move, uint8_t symmetry) {
+    { position.getCanonical() } -> std::same_as<std::pair<G, uint8_t>>;
+    { G::transformMove(move, symmetry) } -> std::same_as<uint8_t>;
+};
+
+// Floats encode() writes for one position of G.
+template<Game G>
+constexpr size_t ENCODED_SIZE = G::PLANES * G::HEIGHT * G::WIDTH;
+
+// Encodes count positions back to back into batch, which must hold count * ENCODED_SIZE<G> floats:
+// the input of a (count, PLANES, HEIGHT, WIDTH) forward, written with no tensor in between.
+template<Game G>
+void encodeBatch(const G *games, size_t count, float *batch) {
+    for (size_t i = 0; i < count; ++i) {
+        games[i].encode(batch + i * ENCODED_SIZE<G>);
+    }
+}
@@ -0,0 +1,591 @@
+#pragma once
+
+#include <cassert>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <exception>
+#include <immintrin.h>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <random>
+#include <thread>
+#include "EvaluationCache.h"
+#include "Evaluator.h"
+#include "Node.h"
+#include "NodeArena.h"
+#include "SearchTree.h"
+#include "TranspositionTable.h"
+
+constexpr float C = 2;
+// Counted as a lost visit on every node of a pending path, so that the other descents of the same
+// batch spread out instead of all reaching the same leaf.
+constexpr float VIRTUAL_LOSS = 1;
+
+// An edge whose mean value is further than this from the mean of the node it leads to catches up
+// on the node instead of descending further.
+constexpr float TRANSPOSITION_EPSILON = 0.01f;
+
+// value is from the view of the player who moved into the leaf of path, and flips sign at every
+// level. Without count_leaf the leaf's own counters are left alone, for a value it already holds.
+template<Game G>
+inline void backpropagate(const Path<G> &path, float value, bool count_leaf = true) {
+    for (int d = path.length - 1; d >= 0; --d) {
+        if (d < path.length - 1 || count_leaf) {
+            path.nodes[d]->_nSims.fetch_add(1, std::memory_order_relaxed);
+            path.nodes[d]->_value.fetch_add(value, std::memory_order_relaxed);
+        }
+        if (d > 0) {
+            Edges<G> &edges = path.nodes[d - 1]->_edges;
+            edges.visits[path.edges[d - 1]].fetch_add(1, std::memory_order_relaxed);
+            edges.values[path.edges[d - 1]].fetch_add(value, std::memory_order_relaxed);
+        }
+        value *= -1;
+    }
+}
+
+template<Game G>
+inline void addVirtualLoss(Node<G> *n, uint8_t edge, int sign) {
+    n->_edges.visits[edge].fetch_add(sign, std::memory_order_relaxed);
+    n->_edges.values[edge].fetch_sub(sign * VIRTUAL_LOSS, std::memory_order_relaxed);
+}
+
+// sign = 1 marks the edges of path as pending, sign = -1 removes the mark again. Node counters are
+// left alone, so they only ever hold finished simulations.
+template<Game G>
+inline void applyVirtualLoss(const Path<G> &path, int sign) {
+    for (int d = 0; d + 1 < path.length; ++d) {
+        addVirtualLoss(path.nodes[d], path.edges[d], sign);
+    }
+}
+
+// Monte-Carlo graph search update for a node shared through the transposition table. An edge that
+// reaches an expanded node with fewer visits than the node has, and whose mean differs from the
+// node's, stops the descent there: the simulation backs up the value that moves the edge's mean onto
+// the node's, which costs no evaluation. Returns nothing when the descent should go on.
+template<Game G>
+inline std::optional<float> catchUpValue(const Node<G> *parent, uint8_t edge, const Node<G> *child) {
+    const int node_visits = child->_nSims.load(std::memory_order_relaxed);
+    const int edge_visits = parent->_edges.visits[edge].load(std::memory_order_relaxed);
+    if (node_visits == 0 || edge_visits >= node_visits) {
+        return std::nullopt;
+    }
+    const float node_q = child->_value.load(std::memory_order_relaxed) / static_cast<float>(node_visits);
+    if (edge_visits <= 0) {
+        return node_q;
+    }
+    const float edge_q = parent->_edges.values[edge].load(std::memory_order_relaxed) /
+                         static_cast<float>(edge_visits);
+    const float delta = node_q - edge_q;
+    if (std::abs(delta) <= TRANSPOSITION_EPSILON) {
+        return std::nullopt;
+    }
+    return std::clamp(delta * static_cast<float>(edge_visits + 1) + edge_q, -1.0f, 1.0f);
+}
+
+// Index of the edge with the best PUCT score
+//
+//   Q + C * P * sqrt(N_parent) / (1 + N),   Q = W / N, or 0 while the edge is unvisited,
+//
+// computed for eight edges per AVX register with the parent term hoisted out of the loop. Padding
+// lanes score -inf and ties go to the lowest index. Each group of eight counters is first copied
+// out with relaxed atomic loads, since other workers may be updating them; under tree-parallel
+// search a lane can be one update stale, which selection tolerates as it does the virtual loss.
+template<Game G>
+inline uint8_t selectUcb(const Node<G> *n) {
+    static_assert(Edges<G>::EDGE_LANES == 8);
+    const Edges<G> &edges = n->_edges;
+    const int count = n->_nMoves;
+    assert(count > 0);
+
+    const __m256 parent = _mm256_set1_ps(C * std::sqrt(static_cast<float>(n->visits())));
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minus_inf = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 best = minus_inf;
+    __m256i best_index = _mm256_setzero_si256();
+
+    alignas(32) int visit_lanes[8];
+    alignas(32) float value_lanes[8];
+    for (int i = 0; i < count; i += 8) {
+        for (int lane = 0; lane < 8; ++lane) {
+            visit_lanes[lane] = edges.visits[i + lane].load(std::memory_order_relaxed);
+            value_lanes[lane] = edges.values[i + lane].load(std::memory_order_relaxed);
+        }
+        __m256 visits = _mm256_cvtepi32_ps(_mm256_load_si256(reinterpret_cast<const __m256i *>(visit_lanes)));
+        __m256 values = _mm256_load_ps(value_lanes);
+        __m256 priors = _mm256_load_ps(edges.priors + i);
+
+        __m256 q = _mm256_div_ps(values, _mm256_max_ps(visits, one));
+        __m256 u = _mm256_div_ps(_mm256_mul_ps(parent, priors), _mm256_add_ps(visits, one));
+        __m256 score = _mm256_add_ps(q, u);
+
+        __m256i index = _mm256_add_epi32(lanes, _mm256_set1_epi32(i));
+        __m256 valid = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(count), index));
+        score = _mm256_blendv_ps(minus_inf, score, valid);
+
+        __m256 better = _mm256_cmp_ps(score, best, _CMP_GT_OQ);
+        best = _mm256_blendv_ps(best, score, better);
+        best_index = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_index),
+                                                          _mm256_castsi256_ps(index), better));
+    }
+
+    alignas(32) float scores[8];
+    alignas(32) int indices[8];
+    _mm256_store_ps(scores, best);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(indices), best_index);
+    int bestI = indices[0];
+    float bestScore = scores[0];
+    for (int lane = 1; lane < 8; ++lane) {
+        if (scores[lane] > bestScore || (scores[lane] == bestScore && indices[lane] < bestI)) {
+            bestScore = scores[lane];
+            bestI = indices[lane];
+        }
+    }
+    return static_cast<uint8_t>(bestI);
+}
+
+// Search over any Game. Node storage, paths and the noise and prior buffers are sized from the
+// game's constants at compile time, and symmetries are only used by games that declare them.
+template<Game G>
+class MCTSLearn {
+private:
+    using Node = ::Node<G>;
+    using Path = ::Path<G>;
+    using Table = TranspositionTable<Node>;
+
+    float dirichlet_epsilon;
+    float dirichlet_alpha;
+    size_t max_batch = 1;
+    bool adaptive_batch = false;
+    bool transpositions = true;
+    bool symmetries = true;
+
+    // A leaf waiting for the batch evaluation of its canonical form, positions[position].
+    struct PendingLeaf {
+        Path path;
+        uint8_t symmetry;
+        size_t position;
+    };
+
+    // What the network is asked about for game: its canonical form when symmetries are on.
+    [[nodiscard]] std::pair<G, uint8_t> evaluatedForm(const G &game) const {
+        if constexpr (SymmetricGame<G>) {
+            if (symmetries) {
+                return game.getCanonical();
+            }
+        }
+        return {game, 0};
+    }
+
+public:
+    MCTSLearn(float dirichlet_epsilon, float dirichlet_alpha) : dirichlet_epsilon(dirichlet_epsilon),
+                                                                dirichlet_alpha(dirichlet_alpha) {}
+
+    // Up to batch_size leaves are collected under virtual loss and evaluated with one evaluateBatch
+    // call. With adaptive set the batch starts at one leaf, doubles while descents keep finding
+    // distinct leaves and halves when two descents meet, so narrow trees are not distorted by a
+    // batch wider than they are.
+    void setBatchSize(size_t batch_size, bool adaptive = false) {
+        if (batch_size == 0) {
+            throw std::invalid_argument("MCTS batch size must be at least 1");
+        }
+        max_batch = batch_size;
+        adaptive_batch = adaptive;
+    }
+
+    // With transpositions on (the default) positions reached through different move orders share
+    // one node, so they are expanded and evaluated once, and the search builds a graph. Off, every
+    // move order gets its own subtree.
+    void setTranspositions(bool enabled) {
+        transpositions = enabled;
+    }
+
+    // With symmetries on (the default) the network only sees the canonical form of a leaf, and its
+    // policy is mapped back onto the leaf's moves, so the symmetric forms of a position share one
+    // evaluation, within a batch and in the cache. Games without symmetries ignore it.
+    void setSymmetries(bool enabled) {
+        symmetries = enabled;
+    }
+
+    // Each simulation walks down to a leaf, evaluates it once, and uses that one evaluation both for
+    // the priors of the new children and for the value that is backed up. Leaves found in the
+    // evaluator's cache are not evaluated again.
+    std::vector<float> search(const G &game, Evaluator<G> &evaluator, int num_searches) {
+        SearchTree<G> &tree = threadTree();
+        tree.reset(game);
+        return search(tree, evaluator, num_searches);
+    }
+
+    // Adds num_searches simulations to a tree kept between moves. The distribution covers every
+    // visit of the root, including those inherited from earlier searches.
+    std::vector<float> search(SearchTree<G> &tree, Evaluator<G> &evaluator, int num_searches) {
+        run(tree, evaluator, num_searches);
+        return visitDistribution(*tree.root());
+    }
+
+    // Tree-parallel search: num_threads workers (the caller included) run simulations on one shared
+    // tree. Each worker holds a virtual loss on its path while it evaluates, and a leaf is expanded
+    // by whichever worker claims it first; the others back off and descend again. The evaluator
+    // must allow concurrent calls; NnmEvaluator and TorchEvaluator only read their model, so they do.
+    std::vector<float> searchParallel(const G &game, Evaluator<G> &evaluator, int num_searches,
+                                      size_t num_threads) {
+        SearchTree<G> &tree = threadTree();
+        tree.reset(game);
+        return searchParallel(tree, evaluator, num_searches, num_threads);
+    }
+
+    std::vector<float> searchParallel(SearchTree<G> &tree, Evaluator<G> &evaluator, int num_searches,
+                                      size_t num_threads) {
+        runParallel(tree, evaluator, num_searches, num_threads);
+        return visitDistribution(*tree.root());
+    }
+
+    // A search advanced one batch of leaves at a time, leaving it to the caller how the leaves are
+    // evaluated. collect() descends to the next batch and returns the positions that still need the
+    // network, which may be none when every leaf was finished, shared or cached; complete() must
+    // follow every collect() with their evaluations, in order. run() evaluates each batch on the
+    // spot, and a coroutine can instead hand the positions to a scheduler that evaluates the leaves
+    // of many searches together.
+    class Search {
+    private:
+        const MCTSLearn &mcts;
+        Node *root;
+        NodeArena &arena;
+        Table *table;
+        EvaluationCache<G> *cache;
+        const Evaluator<G> *stored;
+        int num_searches;
+        int done = 0;
+        size_t batch_size;
+        size_t descents = 0;
+        bool collided = false;
+        std::vector<PendingLeaf> leaves;
+        std::vector<G> positions;
+        std::vector<uint64_t> keys;
+        Evaluation cached;
+        EvaluationView view;
+
+    public:
+        // Leaves found in cache are not evaluated again, and evaluated ones are stored there. Leaves
+        // that stored holds in memory are read from it in place.
+        Search(const MCTSLearn &mcts, SearchTree<G> &tree, EvaluationCache<G> *cache, int num_searches,
+               const Evaluator<G> *stored = nullptr)
+                : mcts(mcts), root(tree.root()), arena(tree.arena()),
+                  table(mcts.transpositions ? &tree.table() : nullptr), cache(cache), stored(stored),
+                  num_searches(num_searches),
+                  batch_size(mcts.adaptive_batch ? 1 : mcts.max_batch) {
+            if (table) {
+                tree.reserve(num_searches);
+            }
+        }
+
+        [[nodiscard]] bool finished() const {
+            return done >= num_searches;
+        }
+
+        const std::vector<G> &collect() {
+            const size_t wanted = std::min(batch_size, static_cast<size_t>(num_searches - done));
+            descents = 0;
+            collided = false;
+            leaves.clear();
+            positions.clear();
+            keys.clear();
+
+            for (; descents < wanted; ++descents) {
+                Path path;
+                if (std::optional<float> shared = select(path, root, arena, table)) {
+                    backpropagate(path, *shared, false);
+                    ++done;
+                    continue;
+                }
+                Node *node = path.leaf();
+                auto [value, terminated] = node->_game.getValueAndTerminated();
+                if (terminated) {
+                    backpropagate(path, value);
+                    ++done;
+                } else if (std::any_of(leaves.begin(), leaves.end(),
+                                       [node](const PendingLeaf &leaf) { return leaf.path.leaf() == node; })) {
+                    collided = true;
+                    break;
+                } else {
+                    auto [form, symmetry] = mcts.evaluatedForm(node->_game);
+                    if (stored && stored->lookup(form, view)) {
+                        mcts.expand(node, view.policy, arena, symmetry);
+                        backpropagate(path, -view.value);
+                        ++done;
+                        continue;
+                    }
+                    const uint64_t key = form.getKey();
+                    if (cache && cache->find(key, cached)) {
+                        mcts.expand(node, cached.policy.data(), arena, symmetry);
+                        backpropagate(path, -cached.value);
+                        ++done;
+                        continue;
+                    }
+                    // Symmetric leaves of one batch share the evaluation of their common form.
+                    size_t position = std::find(keys.begin(), keys.end(), key) - keys.begin();
+                    if (position == keys.size()) {
+                        keys.push_back(key);
+                        positions.push_back(form);
+                    }
+                    applyVirtualLoss(path, 1);
+                    leaves.push_back({path, symmetry, position});
+                }
+            }
+            return positions;
+        }
+
+        void complete(const std::vector<Evaluation> &evaluations) {
+            if (evaluations.size() != positions.size()) {
+                throw std::invalid_argument("Search expected " + std::to_string(positions.size()) +
+                                            " evaluations, got " + std::to_string(evaluations.size()));
+            }
+            if (cache) {
+                for (size_t i = 0; i < positions.size(); ++i) {
+                    cache->store(keys[i], evaluations[i]);
+                }
+            }
+            for (const PendingLeaf &leaf: leaves) {
+                const Evaluation &evaluation = evaluations[leaf.position];
+                applyVirtualLoss(leaf.path, -1);
+                mcts.expand(leaf.path.leaf(), evaluation.policy.data(), arena, leaf.symmetry);
+                backpropagate(leaf.path, -evaluation.value);
+            }
+            done += static_cast<int>(leaves.size());
+            leaves.clear();
+
+            if (mcts.adaptive_batch) {
+                if (collided) {
+                    batch_size = std::max<size_t>(1, batch_size / 2);
+                } else if (descents == batch_size) {
+                    batch_size = std::min(mcts.max_batch, batch_size * 2);
+                }
+            }
+        }
+    };
+
+    void run(SearchTree<G> &tree, Evaluator<G> &evaluator, int num_searches) const {
+        Search search(*this, tree, evaluator.cache(), num_searches, &evaluator);
+        while (!search.finished()) {
+            const std::vector<G> &positions = search.collect();
+            if (positions.empty()) {
+                search.complete({});
+            } else if (positions.size() == 1) {
+                search.complete({evaluator.evaluate(positions[0])});
+            } else {
+                search.complete(evaluator.evaluateBatch(positions));
+            }
+        }
+    }
+
+    void runParallel(SearchTree<G> &tree, Evaluator<G> &evaluator, int num_searches, size_t num_threads) const {
+        Node *root = tree.root();
+        NodeArena &arena = tree.arena();
+        Table *table = transpositions ? &tree.table() : nullptr;
+        if (table) {
+            tree.reserve(num_searches);
+        }
+        std::atomic<int> remaining(num_searches);
+        // The first failure stops every worker and is rethrown once all of them have been joined.
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto worker = [&]() {
+            try {
+                while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0) {
+                    simulate(root, evaluator, arena, table);
+                }
+            } catch (...) {
+                remaining.store(0, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        try {
+            for (size_t t = 1; t < num_threads; ++t) {
+                threads.emplace_back(worker);
+            }
+        } catch (...) {
+            remaining.store(0, std::memory_order_relaxed);
+            for (auto &thread: threads) {
+                thread.join();
+            }
+            throw;
+        }
+        worker();
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    // Root visit counts normalized into a distribution over the moves.
+    static std::vector<float> visitDistribution(const Node &root) {
+        std::vector<float> action_probs(G::ACTION_SIZE, 0.0f);
+        const auto legal_moves = root._game.getLegalMoves();
+        float sum = 0.0f;
+        for (int i = 0; i < (root.isExpanded() ? root._nMoves : 0); ++i) {
+            int move = root._edges.moves[i];
+            if (legal_moves[move]) {
+                action_probs[move] = root._edges.visits[i];
+                sum += action_probs[move];
+            }
+        }
+
+        for (float &probability: action_probs) {
+            probability /= sum;
+        }
+
+        return action_probs;
+    }
+
+    // Follows UCB from the root into path, up to the first node that is terminal or not yet
+    // expanded, creating the nodes along the way that had not been visited before. With a table the
+    // descent can also stop on a shared node its edge has to catch up on; the value to back up for
+    // that edge is returned.
+    static std::optional<float> select(Path &path, Node *root, NodeArena &arena, Table *table) {
+        Node *n = root;
+        path.nodes[0] = root;
+        path.length = 1;
+        while (n->_game.isRunning() && n->isExpanded()) {
+            uint8_t edge = selectUcb(n);
+            Node *child = n->child(edge, arena, table);
+            path.edges[path.length - 1] = edge;
+            path.nodes[path.length++] = child;
+            if (table && child->isExpanded()) {
+                if (std::optional<float> shared = catchUpValue(n, edge, child)) {
+                    return shared;
+                }
+            }
+            n = child;
+        }
+        return std::nullopt;
+    }
+
+    // One simulation that may run concurrently with others on the same graph. The virtual loss is
+    // added edge by edge on the way down so other workers see the path as busy immediately.
+    void simulate(Node *root, Evaluator<G> &evaluator, NodeArena &arena, Table *table) const {
+        while (true) {
+            Path path;
+            path.nodes[0] = root;
+            path.length = 1;
+            Node *node = root;
+            std::optional<float> shared;
+            while (node->_game.isRunning() && node->isExpanded()) {
+                uint8_t edge = selectUcb(node);
+                Node *child = node->child(edge, arena, table);
+                addVirtualLoss(node, edge, 1);
+                path.edges[path.length - 1] = edge;
+                path.nodes[path.length++] = child;
+                if (table && child->isExpanded() && (shared = catchUpValue(node, edge, child))) {
+                    break;
+                }
+                node = child;
+            }
+
+            if (shared) {
+                applyVirtualLoss(path, -1);
+                backpropagate(path, *shared, false);
+                return;
+            }
+            auto [value, terminated] = node->_game.getValueAndTerminated();
+            if (terminated) {
+                applyVirtualLoss(path, -1);
+                backpropagate(path, value);
+                return;
+            }
+            if (node->tryBeginExpansion()) {
+                auto [form, symmetry] = evaluatedForm(node->_game);
+                EvaluationView view;
+                Evaluation evaluation;
+                EvaluationCache<G> *cache = evaluator.cache();
+                // A failed evaluation leaves the leaf unexpanded and the path as it found it.
+                try {
+                    if (!evaluator.lookup(form, view)) {
+                        if (!cache || !cache->find(form.getKey(), evaluation)) {
+                            evaluation = evaluator.evaluate(form);
+                            if (cache) {
+                                cache->store(form.getKey(), evaluation);
+                            }
+                        }
+                        view = {evaluation.policy.data(), evaluation.value};
+                    }
+                    expand(node, view.policy, arena, symmetry);
+                } catch (...) {
+                    node->abortExpansion();
+                    applyVirtualLoss(path, -1);
+                    throw;
+                }
+                applyVirtualLoss(path, -1);
+                backpropagate(path, -view.value);
+                return;
+            }
+            // Another worker is evaluating this leaf; its virtual loss steers the next descent away.
+            applyVirtualLoss(path, -1);
+            std::this_thread::yield();
+        }
+    }
+
+    // Fills the edges of a leaf, with the policy mixed with Dirichlet noise and renormalized over the
+    // legal moves as priors. Child nodes are only created when an edge is first traversed. A policy
+    // over the form of the leaf under symmetry is read back through that symmetry's move map. policy
+    // holds G::ACTION_SIZE probabilities.
+    void expand(Node *n, const float *policy, NodeArena &arena, uint8_t symmetry = 0) const {
+        const auto legal_moves = n->_game.getLegalMoves();
+
+        std::array<float, G::ACTION_SIZE> noise{};
+        float noise_sum = 1.0f;
+        if (dirichlet_epsilon > 0) {
+            thread_local std::mt19937 gen(std::random_device{}());
+            std::gamma_distribution<float> gamma(dirichlet_alpha, 1.0f);
+            noise_sum = 0.0f;
+            for (float &sample: noise) {
+                sample = gamma(gen);
+                noise_sum += sample;
+            }
+        }
+
+        std::array<float, G::ACTION_SIZE> priors{};
+        float policy_sum = 0.0f;
+        for (size_t i = 0; i < G::ACTION_SIZE; ++i) {
+            if (!legal_moves[i]) {
+                continue;
+            }
+            size_t action = i;
+            if constexpr (SymmetricGame<G>) {
+                action = G::transformMove(static_cast<uint8_t>(i), symmetry);
+            }
+            priors[i] = (1 - dirichlet_epsilon) * policy[action] + dirichlet_epsilon * noise[i] / noise_sum;
+            policy_sum += priors[i];
+        }
+
+        Edges<G> edges = Edges<G>::allocate(arena, n->_nMoves);
+        int k = 0;
+        for (size_t i = 0; i < G::ACTION_SIZE; ++i) {
+            if (legal_moves[i]) {
+                edges.moves[k] = static_cast<uint8_t>(i);
+                edges.priors[k++] = priors[i] / policy_sum;
+            }
+        }
+        n->_edges = edges;
+        n->finishExpansion();
+    }
+
+    // Each thread keeps a tree, arena and table included, from one search to the next, so searches
+    // cost no heap allocation once it has grown to the largest tree seen.
+    static SearchTree<G> &threadTree() {
+        thread_local SearchTree<G> tree{G()};
+        return tree;
+    }
+
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include "Game.h"
+#include "NodeArena.h"
+#include "TranspositionTable.h"
+
+enum class Expansion : uint8_t {
+    none,
+    pending,
+    done
+};
+
+template<Game G>
+struct Node;
+
+// Per-action statistics of an expanded node as parallel arrays, so selection reads each statistic
+// contiguously instead of chasing one pointer per child. Arrays hold the legal moves in order and
+// are padded with zeroed entries to a multiple of EDGE_LANES; their size is set per node at
+// expansion, so a node of a game with a large action space pays only for its legal moves.
+template<Game G>
+struct Edges {
+    static constexpr size_t EDGE_LANES = 8;
+
+    uint8_t *moves = nullptr;
+    float *priors = nullptr;
+    std::atomic<int> *visits = nullptr;
+    // Sum of backed-up values, from the view of the player making the move.
+    std::atomic<float> *values = nullptr;
+    // Created on the first traversal of the edge.
+    std::atomic<Node<G> *> *children = nullptr;
+
+    static size_t padded(size_t count) {
+        return (count + EDGE_LANES - 1) / EDGE_LANES * EDGE_LANES;
+    }
+
+    // One arena block for all arrays of count edges, zero-initialized.
+    static Edges allocate(NodeArena &arena, size_t count) {
+        const size_t n = padded(count);
+        auto *bytes = static_cast<std::byte *>(arena.allocateBytes(
+                n * (sizeof(Node<G> *) + sizeof(float) + sizeof(int) + sizeof(float) + sizeof(uint8_t))));
+        Edges edges;
+        edges.children = reinterpret_cast<std::atomic<Node<G> *> *>(bytes);
+        edges.priors = reinterpret_cast<float *>(bytes + n * sizeof(Node<G> *));
+        edges.visits = reinterpret_cast<std::atomic<int> *>(edges.priors + n);
+        edges.values = reinterpret_cast<std::atomic<float> *>(edges.visits + n);
+        edges.moves = reinterpret_cast<uint8_t *>(edges.values + n);
+        for (size_t i = 0; i < n; ++i) {
+            new(&edges.children[i]) std::atomic<Node<G> *>(nullptr);
+            edges.priors[i] = 0.0f;
+            new(&edges.visits[i]) std::atomic<int>(0);
+            new(&edges.values[i]) std::atomic<float>(0.0f);
+            edges.moves[i] = 0;
+        }
+        return edges;
+    }
+};
+
+// A position in the search graph. With a transposition table a node can be the child of several
+// edges, each of which keeps its own visits and values; the node's own counters sum up the
+// simulations through all of them. Statistics are atomic so that several search threads can share
+// one graph. Edges are written by the single thread that wins tryBeginExpansion and read only once
+// isExpanded() returns true. All memory belongs to a NodeArena.
+template<Game G>
+struct Node {
+    std::atomic<int> _nSims;
+    // Sum of backed-up values, from the view of the player who moved into the node.
+    std::atomic<float> _value;
+    std::atomic<Expansion> _expansion{Expansion::none};
+    G _game;
+    uint8_t _nMoves;
+    Edges<G> _edges;
+    // Where SearchTree::advance() copied the node to, so a node shared by several edges is copied once.
+    Node *_copy = nullptr;
+
+    Node(const Node &) = delete;
+
+    explicit Node(const G &game) : _nSims(0), _value(0.0f), _game(game), _nMoves(game.CountLegalMoves()) {
+    }
+
+    // True for exactly one caller; that caller must expand the node and call finishExpansion(), or
+    // abortExpansion() when it fails.
+    bool tryBeginExpansion() {
+        Expansion expected = Expansion::none;
+        return _expansion.compare_exchange_strong(expected, Expansion::pending, std::memory_order_acq_rel);
+    }
+
+    void finishExpansion() {
+        _expansion.store(Expansion::done, std::memory_order_release);
+    }
+
+    // Hands a claimed node back unexpanded, for a caller that could not expand it.
+    void abortExpansion() {
+        _expansion.store(Expansion::none, std::memory_order_release);
+    }
+
+    [[nodiscard]] int visits() const {
+        return _nSims.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool isExpanded() const {
+        return _expansion.load(std::memory_order_acquire) == Expansion::done;
+    }
+
+    // The node behind edge i, set on first use. With a table, a node already standing for the
+    // position is shared; otherwise a new node is created in the arena. When threads race to set
+    // the edge, one node wins and the others stay unused in the arena until it is reset.
+    Node *child(uint8_t i, NodeArena &arena, TranspositionTable<Node> *table = nullptr) {
+        Node *existing = _edges.children[i].load(std::memory_order_acquire);
+        if (existing) {
+            return existing;
+        }
+        G next = _game;
+        next.makeMove(_edges.moves[i]);
+        Node *created = table ? table->find(next.getKey()) : nullptr;
+        if (created == nullptr) {
+            created = new(arena.allocate<Node>(1)) Node(next);
+            if (table) {
+                created = table->insert(next.getKey(), created);
+            }
+        }
+        if (_edges.children[i].compare_exchange_strong(existing, created, std::memory_order_acq_rel)) {
+            return created;
+        }
+        return existing;
+    }
+};
+
+// The nodes of one descent, from the root, and the edge taken out of each of them but the last.
+// In a graph a node has no single parent, so updates follow the path that was actually walked.
+// The bound on the game length sizes both arrays at compile time.
+template<Game G>
+struct Path {
+    std::array<Node<G> *, G::MAX_GAME_LENGTH + 1> nodes;
+    std::array<uint8_t, G::MAX_GAME_LENGTH> edges;
+    int length = 0;
+
+    [[nodiscard]] Node<G> *leaf() const {
+        return nodes[length - 1];
+    }
+};
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+// Bump allocator for search trees. Nodes and edge arrays are carved out of fixed-size chunks that
+// are kept across searches, so a warmed-up search does no heap allocation and reset() drops a whole
+// tree in O(1): everything stored here is trivially destructible and nothing is ever freed
+// individually. Several threads may allocate at once.
+class NodeArena {
+public:
+    static constexpr size_t CHUNK_BYTES = 256 * 1024;
+    // Every allocation starts on this boundary, enough for aligned AVX loads.
+    static constexpr size_t ALIGNMENT = 32;
+
+private:
+    struct FreeBytes {
+        void operator()(std::byte *bytes) const {
+            ::operator delete(bytes, std::align_val_t(ALIGNMENT));
+        }
+    };
+
+    struct Chunk {
+        std::unique_ptr<std::byte, FreeBytes> bytes;
+        std::atomic<size_t> used{0};
+
+        Chunk() : bytes(static_cast<std::byte *>(::operator new(CHUNK_BYTES, std::align_val_t(ALIGNMENT)))) {}
+    };
+
+    std::vector<std::unique_ptr<Chunk>> chunks;
+    std::atomic<Chunk *> current{nullptr};
+    size_t current_index = 0;
+    std::mutex grow;
+
+    // Moves to the next chunk, reusing one from an earlier search when there is one.
+    void advance(Chunk *full) {
+        std::lock_guard<std::mutex> lock(grow);
+        if (current.load(std::memory_order_acquire) != full) {
+            return;
+        }
+        if (full != nullptr) {
+            ++current_index;
+        }
+        if (current_index == chunks.size()) {
+            chunks.push_back(std::make_unique<Chunk>());
+        }
+        Chunk *next = chunks[current_index].get();
+        next->used.store(0, std::memory_order_relaxed);
+        current.store(next, std::memory_order_release);
+    }
+
+public:
+    NodeArena() = default;
+
+    NodeArena(const NodeArena &) = delete;
+
+    NodeArena &operator=(const NodeArena &) = delete;
+
+    // Uninitialized, ALIGNMENT-aligned room for bytes bytes.
+    void *allocateBytes(size_t bytes) {
+        bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        if (bytes > CHUNK_BYTES) {
+            throw std::invalid_argument("Cannot allocate more than one arena chunk at once");
+        }
+        while (true) {
+            Chunk *chunk = current.load(std::memory_order_acquire);
+            if (chunk != nullptr) {
+                size_t begin = chunk->used.fetch_add(bytes, std::memory_order_relaxed);
+                if (begin + bytes <= CHUNK_BYTES) {
+                    return chunk->bytes.get() + begin;
+                }
+            }
+            advance(chunk);
+        }
+    }
+
+    // Uninitialized room for count objects, to be constructed with placement new.
+    template<typename T>
+    T *allocate(size_t count) {
+        static_assert(alignof(T) <= ALIGNMENT);
+        static_assert(std::is_trivially_destructible_v<T>, "arena memory is never destroyed");
+        return static_cast<T *>(allocateBytes(count * sizeof(T)));
+    }
+
+    // Forgets everything handed out so far. Must not race with allocation.
+    void reset() {
+        current_index = 0;
+        if (!chunks.empty()) {
+            chunks[0]->used.store(0, std::memory_order_relaxed);
+            current.store(chunks[0].get(), std::memory_order_release);
+        }
+    }
+
+    [[nodiscard]] size_t chunkCount() const {
+        return chunks.size();
+    }
+};
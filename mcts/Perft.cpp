@@ -0,0 +1,39 @@
+// Move-generation benchmark for UltimateTicTacToe: counts the move sequences of every length up to
+// the given depth from the empty board and reports how many positions per second that reaches.
+//
+//   Perft [depth]
+//
+// The counts from the empty board are 81, 720, 6336, 55080, 473256, 4020960, 33782544, 281067408;
+// a different number means move generation changed.
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include "UltimateTicTacToe.h"
+
+int main(int argc, char **argv) {
+    int max_depth = 8;
+    if (argc > 1) {
+        try {
+            max_depth = std::stoi(argv[1]);
+        } catch (const std::exception &) {
+            max_depth = 0;
+        }
+        if (max_depth < 1 || max_depth > static_cast<int>(UltimateTicTacToe::MAX_GAME_LENGTH)) {
+            std::cerr << "Usage: Perft [depth], depth between 1 and " << UltimateTicTacToe::MAX_GAME_LENGTH
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    std::printf("%5s %15s %10s %12s\n", "depth", "positions", "seconds", "Mpos/s");
+    for (int depth = 1; depth <= max_depth; ++depth) {
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t positions = UltimateTicTacToe::perft(UltimateTicTacToe(), depth);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::printf("%5d %15llu %10.3f %12.1f\n", depth, static_cast<unsigned long long>(positions), seconds,
+                    seconds > 0.0 ? static_cast<double>(positions) / seconds / 1e6 : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <immintrin.h>
+
+// Writes the low nine bits of bits to out[0..8] as 1.0f and 0.0f, bit i to out[i]. The first eight
+// come from one AVX compare of the broadcast bits against the lane bits, with no table and no
+// branch per cell, so a 3x3 board or one row of a 9x9 board costs a handful of instructions.
+inline void expandBits(uint32_t bits, float *out) {
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i set = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lane_bits),
+                                           lane_bits);
+    _mm256_storeu_ps(out, _mm256_and_ps(_mm256_castsi256_ps(set), _mm256_set1_ps(1.0f)));
+    out[8] = static_cast<float>(bits >> 8 & 1);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include "Evaluator.h"
+#include "TicTacToe.h"
+
+// Serves every reachable TicTacToe position from a table filled by a model ahead of time. There are
+// only 5478 legal positions, so refresh() evaluates all the non-terminal ones in a few large
+// batches. Afterwards a search reads a leaf through lookup(), which loads the slot indexed by the
+// position code and points into that slot's entry, so a leaf costs no forward pass and no copy.
+// evaluate() copies the entry into an Evaluation for callers outside the search. Refresh whenever
+// the model's weights change; the table holds no reference to the model.
+class PrecomputedEvaluator final : public Evaluator<TicTacToe> {
+public:
+    static constexpr size_t BATCH_SIZE = 1024;
+
+private:
+    static constexpr uint16_t NO_ENTRY = std::numeric_limits<uint16_t>::max();
+
+    struct Entry {
+        std::array<float, 9> policy;
+        float value;
+    };
+
+    // Indexed by position code.
+    std::vector<uint16_t> slots = std::vector<uint16_t>(POSITION_CODES, NO_ENTRY);
+    std::vector<Entry> entries;
+
+public:
+    explicit PrecomputedEvaluator(Evaluator<TicTacToe> &model) {
+        refresh(model);
+    }
+
+    // Evaluates every reachable running position with model, BATCH_SIZE positions per call.
+    void refresh(Evaluator<TicTacToe> &model) {
+        const std::vector<TicTacToe> &running = TicTacToe::runningPositions();
+        std::fill(slots.begin(), slots.end(), NO_ENTRY);
+        entries.assign(running.size(), Entry{});
+        evaluateInBatches(model, running, BATCH_SIZE, [this](size_t begin, const std::vector<TicTacToe> &batch,
+                                                            const std::vector<Evaluation> &evaluations) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                Entry &entry = entries[begin + i];
+                std::copy(evaluations[i].policy.begin(), evaluations[i].policy.end(), entry.policy.begin());
+                entry.value = evaluations[i].value;
+                slots[batch[i].getCode()] = static_cast<uint16_t>(begin + i);
+            }
+        });
+    }
+
+    [[nodiscard]] bool contains(const TicTacToe &game) const {
+        return slots[game.getCode()] != NO_ENTRY;
+    }
+
+    bool lookup(const TicTacToe &game, EvaluationView &view) const override {
+        const uint16_t slot = slots[game.getCode()];
+        if (slot == NO_ENTRY) {
+            return false;
+        }
+        view = {entries[slot].policy.data(), entries[slot].value};
+        return true;
+    }
+
+    Evaluation evaluate(const TicTacToe &game) override {
+        const uint16_t slot = slots[game.getCode()];
+        if (slot == NO_ENTRY) {
+            throw std::invalid_argument("Position is finished or not reachable, so it has no precomputed evaluation");
+        }
+        const Entry &entry = entries[slot];
+        return {std::vector<float>(entry.policy.begin(), entry.policy.end()), entry.value};
+    }
+
+    [[nodiscard]] size_t size() const {
+        return entries.size();
+    }
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include "Node.h"
+#include "NodeArena.h"
+#include "TranspositionTable.h"
+
+// A search graph that outlives a single search. After a move is played, advance() keeps everything
+// reachable from that move, with its visits, values and priors, and releases the rest, so the next
+// search starts from what the previous ones already learned.
+//
+// Two arenas and tables take turns: the kept part is copied into the idle pair and the old pair is
+// reset, so releasing the rest stays O(1) in the arena and the copy costs only what is kept.
+template<Game G>
+class SearchTree {
+private:
+    using Node = ::Node<G>;
+
+    NodeArena arenas[2];
+    TranspositionTable<Node> tables[2];
+    int active = 0;
+    Node *root_node = nullptr;
+
+    // Copies source and everything reachable from it into arena, copying a node shared by several
+    // edges once. Each source node records its copy, which is fine as the source arena is reset
+    // right after.
+    static Node *copyGraph(Node *source, NodeArena &arena, TranspositionTable<Node> &table) {
+        if (source->_copy != nullptr) {
+            return source->_copy;
+        }
+        Node *copy = new(arena.allocate<Node>(1)) Node(source->_game);
+        copy->_nSims = source->_nSims.load(std::memory_order_relaxed);
+        copy->_value = source->_value.load(std::memory_order_relaxed);
+        source->_copy = copy;
+        table.insert(copy->_game.getKey(), copy);
+        if (!source->isExpanded()) {
+            return copy;
+        }
+
+        const Edges<G> &from = source->_edges;
+        Edges<G> to = Edges<G>::allocate(arena, source->_nMoves);
+        for (uint8_t i = 0; i < source->_nMoves; ++i) {
+            to.moves[i] = from.moves[i];
+            to.priors[i] = from.priors[i];
+            to.visits[i] = from.visits[i].load(std::memory_order_relaxed);
+            to.values[i] = from.values[i].load(std::memory_order_relaxed);
+        }
+        copy->_edges = to;
+        for (uint8_t i = 0; i < source->_nMoves; ++i) {
+            if (Node *child = from.children[i].load(std::memory_order_acquire)) {
+                to.children[i] = copyGraph(child, arena, table);
+            }
+        }
+        copy->finishExpansion();
+        return copy;
+    }
+
+public:
+    explicit SearchTree(const G &game) {
+        reset(game);
+    }
+
+    SearchTree(const SearchTree &) = delete;
+
+    SearchTree &operator=(const SearchTree &) = delete;
+
+    // Drops the whole tree and starts over from game.
+    void reset(const G &game) {
+        arenas[active].reset();
+        tables[active].clear();
+        tables[active].reserve(1);
+        root_node = new(arenas[active].allocate<Node>(1)) Node(game);
+        tables[active].insert(game.getKey(), root_node);
+    }
+
+    // Makes the position after move the new root, keeping its subtree when it was searched.
+    void advance(uint8_t move) {
+        Node *child = nullptr;
+        if (!root_node->isExpanded()) {
+            const G &game = root_node->_game;
+            if (!game.isRunning() || move >= G::ACTION_SIZE || !game.getLegalMoves()[move]) {
+                throw std::invalid_argument("Move " + std::to_string(move) + " is not legal at the search root");
+            }
+        } else {
+            const Edges<G> &edges = root_node->_edges;
+            const uint8_t *found = std::find(edges.moves, edges.moves + root_node->_nMoves, move);
+            if (found == edges.moves + root_node->_nMoves) {
+                throw std::invalid_argument("Move " + std::to_string(move) + " is not legal at the search root");
+            }
+            child = edges.children[found - edges.moves].load(std::memory_order_acquire);
+        }
+        if (child == nullptr) {
+            G next = root_node->_game;
+            next.makeMove(move);
+            reset(next);
+            return;
+        }
+
+        NodeArena &next = arenas[1 - active];
+        TranspositionTable<Node> &next_table = tables[1 - active];
+        next.reset();
+        next_table.clear();
+        next_table.reserve(tables[active].size());
+        root_node = copyGraph(child, next, next_table);
+        arenas[active].reset();
+        tables[active].clear();
+        active = 1 - active;
+    }
+
+    // Makes room in the table for the nodes of another simulations simulations, each of which adds
+    // one at most. Only searches that share transpositions need it. Must not race with a search.
+    void reserve(size_t simulations) {
+        tables[active].reserve(tables[active].size() + simulations + 1);
+    }
+
+    [[nodiscard]] Node *root() const {
+        return root_node;
+    }
+
+    [[nodiscard]] NodeArena &arena() {
+        return arenas[active];
+    }
+
+    [[nodiscard]] TranspositionTable<Node> &table() {
+        return tables[active];
+    }
+
+    [[nodiscard]] const G &game() const {
+        return root_node->_game;
+    }
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Evaluator.h"
+#include "TicTacToe.h"
+
+// How a model's network compares with perfect play over every running position.
+struct PolicyScore {
+    size_t positions = 0;
+    // Fraction of positions where the policy's most likely legal move is optimal.
+    float move_accuracy = 0.0f;
+    // Mean probability the policy puts on optimal moves.
+    float optimal_mass = 0.0f;
+    // Mean absolute difference between the value head and the exact value.
+    float value_error = 0.0f;
+};
+
+// Exact values of every reachable position, from one memoized negamax over the whole game tree.
+// Values are from the view of the player to move: 1 a forced win, 0 a draw, -1 a forced loss.
+// Solving takes well under a millisecond, so a model can be graded against perfect play instead of
+// against another model.
+class Solver {
+private:
+    static constexpr int8_t UNSOLVED = 2;
+
+    // Indexed by position code.
+    std::vector<int8_t> values = std::vector<int8_t>(POSITION_CODES, UNSOLVED);
+
+    int8_t solve(const TicTacToe &game) {
+        int8_t &value = values[game.getCode()];
+        if (value != UNSOLVED) {
+            return value;
+        }
+        auto [result, terminated] = game.getValueAndTerminated();
+        if (terminated) {
+            // The result is for the player who just moved.
+            value = static_cast<int8_t>(-result);
+            return value;
+        }
+        int8_t best = -1;
+        const auto legal_moves = game.getLegalMoves();
+        for (uint8_t move = 0; move < 9; ++move) {
+            if (legal_moves[move]) {
+                TicTacToe next = game;
+                next.makeMove(move);
+                best = std::max(best, static_cast<int8_t>(-solve(next)));
+            }
+        }
+        value = best;
+        return value;
+    }
+
+public:
+    Solver() {
+        solve(TicTacToe());
+    }
+
+    // Solved on first use and shared afterwards.
+    static const Solver &instance() {
+        static const Solver solver;
+        return solver;
+    }
+
+    [[nodiscard]] int value(const TicTacToe &game) const {
+        return values[game.getCode()];
+    }
+
+    // 1 for every legal move that keeps the position's value, 0 elsewhere.
+    [[nodiscard]] std::array<uint8_t, 9> optimalMoves(const TicTacToe &game) const {
+        std::array<uint8_t, 9> optimal{};
+        const auto legal_moves = game.getLegalMoves();
+        const int best = value(game);
+        for (uint8_t move = 0; move < 9; ++move) {
+            if (legal_moves[move]) {
+                TicTacToe next = game;
+                next.makeMove(move);
+                optimal[move] = -value(next) == best;
+            }
+        }
+        return optimal;
+    }
+
+    // Grades evaluator on all running positions, evaluated in batches of batch_size.
+    [[nodiscard]] PolicyScore scorePolicy(Evaluator<TicTacToe> &evaluator, size_t batch_size = 1024) const {
+        const std::vector<TicTacToe> &running = TicTacToe::runningPositions();
+        PolicyScore score;
+        score.positions = running.size();
+        size_t correct = 0;
+        double mass = 0.0;
+        double error = 0.0;
+        evaluateInBatches(evaluator, running, batch_size, [&](size_t, const std::vector<TicTacToe> &batch,
+                                                              const std::vector<Evaluation> &evaluations) {
+            for (size_t i = 0; i < batch.size(); ++i) {
+                const auto legal_moves = batch[i].getLegalMoves();
+                const auto optimal = optimalMoves(batch[i]);
+                const std::vector<float> &policy = evaluations[i].policy;
+                int chosen = -1;
+                float legal_mass = 0.0f;
+                float optimal_mass = 0.0f;
+                for (uint8_t move = 0; move < 9; ++move) {
+                    if (!legal_moves[move]) {
+                        continue;
+                    }
+                    if (chosen < 0 || policy[move] > policy[chosen]) {
+                        chosen = move;
+                    }
+                    legal_mass += policy[move];
+                    optimal_mass += optimal[move] ? policy[move] : 0.0f;
+                }
+                correct += optimal[chosen];
+                mass += legal_mass > 0.0f ? optimal_mass / legal_mass : 0.0f;
+                error += std::abs(evaluations[i].value - static_cast<float>(value(batch[i])));
+            }
+        });
+        score.move_accuracy = static_cast<float>(correct) / static_cast<float>(score.positions);
+        score.optimal_mass = static_cast<float>(mass / static_cast<double>(score.positions));
+        score.value_error = static_cast<float>(error / static_cast<double>(score.positions));
+        return score;
+    }
+};
+
+// Decides promotion during training by grading against perfect play. It keeps the score of the best
+// model rather than the model itself, so a candidate is measured against what the best weights
+// achieved even after those weights have been trained further.
+class SolverGate {
+private:
+    PolicyScore best_score;
+
+public:
+    // The model training starts from sets the first bar.
+    explicit SolverGate(Evaluator<TicTacToe> &initial) : best_score(Solver::instance().scorePolicy(initial)) {}
+
+    // Grades candidate into score and promotes it when its move accuracy is at least the best
+    // model's. Returns 0.5 plus half the accuracy gain, so like a match score it is at least 0.5
+    // exactly when the candidate is promoted.
+    float offer(Evaluator<TicTacToe> &candidate, PolicyScore &score) {
+        score = Solver::instance().scorePolicy(candidate);
+        const float result = 0.5f + 0.5f * (score.move_accuracy - best_score.move_accuracy);
+        if (score.move_accuracy >= best_score.move_accuracy) {
+            best_score = score;
+        }
+        return result;
+    }
+
+    [[nodiscard]] const PolicyScore &best() const {
+        return best_score;
+    }
+};
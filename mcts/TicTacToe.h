@@ -0,0 +1,326 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "Game.h"
+#include "Planes.h"
+#include "Tensor4D.h"
+
+constexpr uint16_t BOARD_MASK = 511;
+
+// Positions written as base-3 numbers, cell i being digit i: 0 empty, 1 x, 2 o. Every position has
+// its own code below POSITION_CODES, so codes index flat per-position tables.
+constexpr size_t POSITION_CODES = 19683;
+
+// TERNARY[board] spells out a bitboard in base 3 with digit 1 for every set cell.
+constexpr std::array<uint16_t, BOARD_MASK + 1> TERNARY = [] {
+    std::array<uint16_t, BOARD_MASK + 1> ternary{};
+    for (int board = 0; board <= BOARD_MASK; ++board) {
+        uint16_t power = 1;
+        for (int cell = 0; cell < 9; ++cell, power *= 3) {
+            if (board & 1 << cell) {
+                ternary[board] += power;
+            }
+        }
+    }
+    return ternary;
+}();
+
+constexpr int SYMMETRY_COUNT = 8;
+
+// The dihedral symmetries of the board as cell permutations: symmetry s moves cell i to
+// SYMMETRY_CELLS[s][i]. 0 is the identity, then the three rotations and the four reflections.
+constexpr std::array<std::array<uint8_t, 9>, SYMMETRY_COUNT> SYMMETRY_CELLS = [] {
+    std::array<std::array<uint8_t, 9>, SYMMETRY_COUNT> cells{};
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) {
+            const std::array<std::pair<int, int>, SYMMETRY_COUNT> to = {{
+                    {r, c}, {c, 2 - r}, {2 - r, 2 - c}, {2 - c, r},
+                    {r, 2 - c}, {2 - r, c}, {c, r}, {2 - c, 2 - r}}};
+            for (int s = 0; s < SYMMETRY_COUNT; ++s) {
+                cells[s][r * 3 + c] = static_cast<uint8_t>(to[s].first * 3 + to[s].second);
+            }
+        }
+    }
+    return cells;
+}();
+
+// SYMMETRY_BOARDS[s][board] is the bitboard with symmetry s applied, so a transform is one lookup.
+constexpr std::array<std::array<uint16_t, BOARD_MASK + 1>, SYMMETRY_COUNT> SYMMETRY_BOARDS = [] {
+    std::array<std::array<uint16_t, BOARD_MASK + 1>, SYMMETRY_COUNT> boards{};
+    for (int s = 0; s < SYMMETRY_COUNT; ++s) {
+        for (int board = 0; board <= BOARD_MASK; ++board) {
+            for (int cell = 0; cell < 9; ++cell) {
+                if (board & 1 << cell) {
+                    boards[s][board] |= static_cast<uint16_t>(1 << SYMMETRY_CELLS[s][cell]);
+                }
+            }
+        }
+    }
+    return boards;
+}();
+
+enum class Player : uint8_t {
+    x = 0,
+    o = 1
+};
+
+enum class GameState : uint8_t {
+    x_win = 0,
+    o_win = 1,
+    draw = 2,
+    running = 3
+};
+
+
+struct TicTacToe {
+    static constexpr size_t ACTION_SIZE = 9;
+    static constexpr size_t MAX_GAME_LENGTH = 9;
+    static constexpr size_t PLANES = 3;
+    static constexpr size_t HEIGHT = 3;
+    static constexpr size_t WIDTH = 3;
+
+private:
+    uint16_t x_board;
+    uint16_t o_board;
+    GameState game_state;
+    Player currentPlayer;
+
+    static bool checkWin(uint16_t board) {
+        uint16_t horizontal = 0b000000111;
+        for (int i = 0; i < 3; i++) {
+            if ((board & horizontal) == horizontal) return true;
+            horizontal <<= 3;
+        }
+
+        uint16_t vertical = 0b000000001 | (0b000000001 << 3) | (0b000000001 << 6);
+        for (int i = 0; i < 3; i++) {
+            if ((board & vertical) == vertical) return true;
+            vertical <<= 1;
+        }
+
+        uint16_t diagonal1 = 0b100010001;
+        uint16_t diagonal2 = 0b001010100;
+        if ((board & diagonal1) == diagonal1 || (board & diagonal2) == diagonal2) return true;
+
+        return false;
+    }
+
+public:
+    TicTacToe() : x_board(0), o_board(0), game_state(GameState::running), currentPlayer(Player::x) {}
+
+    TicTacToe(const TicTacToe &other) : x_board(other.x_board), o_board(other.o_board), game_state(other.game_state),
+                                        currentPlayer(other.currentPlayer) {}
+
+    void makeMove(uint8_t move) {
+        uint16_t bit = 1 << move;
+        if (currentPlayer == Player::x) {
+            x_board |= bit;
+            game_state = checkWin(x_board) ? GameState::x_win : GameState::running;
+            currentPlayer = Player::o;
+        } else if (currentPlayer == Player::o) {
+            o_board |= bit;
+            game_state = checkWin(o_board) ? GameState::o_win : GameState::running;
+            currentPlayer = Player::x;
+        }
+
+        if (game_state == GameState::running && (x_board | o_board) == BOARD_MASK) {
+            game_state = GameState::draw;
+        }
+    }
+
+    [[nodiscard]] std::array<uint8_t, 9> getLegalMoves() const {
+        uint16_t board = ~(x_board | o_board) & BOARD_MASK;
+        std::array<uint8_t, 9> legal_moves{};
+        while (board) {
+            uint8_t move = __builtin_ctz(board);
+            board &= board - 1;
+            legal_moves[move] = 1;
+        }
+        return legal_moves;
+    }
+
+    void printLegalMoves() const {
+        auto legal_moves = getLegalMoves();
+        std::cout << "Legal moves: ";
+        for (int i = 0; i < 9; i++) {
+            if (legal_moves[i]) {
+                std::cout << i << " ";
+            } else {
+                std::cout << ". ";
+            }
+        }
+        std::cout << std::endl;
+    }
+
+    // Planes of the stones of the player to move, the opponent's stones and the empty cells, each
+    // expanded from its bitboard in one go.
+    void encode(float *planes) const {
+        const bool x_to_move = currentPlayer == Player::x;
+        expandBits(x_to_move ? x_board : o_board, planes);
+        expandBits(x_to_move ? o_board : x_board, planes + 9);
+        expandBits(~(x_board | o_board) & BOARD_MASK, planes + 18);
+    }
+
+    [[nodiscard]] nnm::Tensor4D getEncodedState() const {
+        nnm::Tensor4D tensor(1, PLANES, HEIGHT, WIDTH);
+        encode(tensor.getData().data());
+        return tensor;
+    }
+
+    // Identifies the position: both bitboards side by side. The player to move and the game state
+    // follow from the boards, so equal keys mean equal positions whatever the move order.
+    [[nodiscard]] uint64_t getKey() const {
+        return x_board | static_cast<uint64_t>(o_board) << 9;
+    }
+
+    bool operator==(const TicTacToe &) const = default;
+
+    // The position's base-3 code, a perfect hash into tables of POSITION_CODES entries.
+    [[nodiscard]] size_t getCode() const {
+        return TERNARY[x_board] + 2 * TERNARY[o_board];
+    }
+
+    // The position with symmetry applied to the board. The player to move and the result stay the same.
+    [[nodiscard]] TicTacToe transformed(uint8_t symmetry) const {
+        TicTacToe game(*this);
+        game.x_board = SYMMETRY_BOARDS[symmetry][x_board];
+        game.o_board = SYMMETRY_BOARDS[symmetry][o_board];
+        return game;
+    }
+
+    // The cell move lands on under symmetry.
+    static uint8_t transformMove(uint8_t move, uint8_t symmetry) {
+        return SYMMETRY_CELLS[symmetry][move];
+    }
+
+    // The form of the position with the smallest key, which all eight symmetric forms share, and the
+    // symmetry that maps this position onto it. A move m here is move SYMMETRY_CELLS[symmetry][m]
+    // in the canonical form.
+    [[nodiscard]] std::pair<TicTacToe, uint8_t> getCanonical() const {
+        uint8_t best = 0;
+        uint64_t best_key = getKey();
+        for (uint8_t s = 1; s < SYMMETRY_COUNT; ++s) {
+            uint64_t key = SYMMETRY_BOARDS[s][x_board] | static_cast<uint64_t>(SYMMETRY_BOARDS[s][o_board]) << 9;
+            if (key < best_key) {
+                best_key = key;
+                best = s;
+            }
+        }
+        return {transformed(best), best};
+    }
+
+    [[nodiscard]] GameState getGameState() const {
+        return game_state;
+    }
+
+    [[nodiscard]] int getActionSize() const {
+        return 9;
+    }
+
+    [[nodiscard]] std::pair<float, bool> getValueAndTerminated() const {
+        switch (game_state) {
+            case GameState::x_win:
+                return {currentPlayer == Player::o ? 1.0f : -1.0f, true};
+            case GameState::o_win:
+                return {currentPlayer == Player::x ? 1.0f : -1.0f, true};
+            case GameState::draw:
+                return {0.0f, true};
+            case GameState::running:
+                return {0.0f, false};
+            default:
+                throw std::runtime_error("Invalid game state");
+        }
+    }
+
+    void printBoard() const {
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                if (x_board & (1 << (i * 3 + j))) {
+                    std::cout << "X ";
+                } else if (o_board & (1 << (i * 3 + j))) {
+                    std::cout << "O ";
+                } else {
+                    std::cout << ". ";
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    TicTacToe *clone() {
+        auto *game = new TicTacToe();
+        game->x_board = x_board;
+        game->o_board = o_board;
+        game->game_state = game_state;
+        game->currentPlayer = currentPlayer;
+        return game;
+    }
+
+    Player getCurrentPlayer() const {
+        return currentPlayer;
+    }
+
+    bool isRunning() const {
+        return game_state == GameState::running;
+    }
+
+    int CountLegalMoves() const {
+        auto legal_moves = getLegalMoves();
+        return std::count(legal_moves.begin(), legal_moves.end(), 1);
+    }
+
+    static constexpr size_t REACHABLE_POSITIONS = 5478;
+
+    // Every position reachable from the empty board, finished games included, each once.
+    static const std::vector<TicTacToe> &reachablePositions() {
+        static const std::vector<TicTacToe> positions = [] {
+            std::vector<TicTacToe> found;
+            std::vector<bool> seen(POSITION_CODES, false);
+            std::vector<TicTacToe> pending = {TicTacToe()};
+            seen[0] = true;
+            while (!pending.empty()) {
+                TicTacToe game = pending.back();
+                pending.pop_back();
+                found.push_back(game);
+                if (!game.isRunning()) {
+                    continue;
+                }
+                const auto legal_moves = game.getLegalMoves();
+                for (uint8_t move = 0; move < 9; ++move) {
+                    if (legal_moves[move]) {
+                        TicTacToe next = game;
+                        next.makeMove(move);
+                        if (!seen[next.getCode()]) {
+                            seen[next.getCode()] = true;
+                            pending.push_back(next);
+                        }
+                    }
+                }
+            }
+            return found;
+        }();
+        return positions;
+    }
+
+    // The reachable positions whose game is still running: the ones a network is asked about.
+    static const std::vector<TicTacToe> &runningPositions() {
+        static const std::vector<TicTacToe> positions = [] {
+            std::vector<TicTacToe> running;
+            for (const TicTacToe &game: reachablePositions()) {
+                if (game.isRunning()) {
+                    running.push_back(game);
+                }
+            }
+            return running;
+        }();
+        return positions;
+    }
+};
+
+static_assert(SymmetricGame<TicTacToe>);
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Maps position keys to the search node that stands for the position, so that a position reached
+// through different move orders is expanded and evaluated once. Open addressing with linear probing
+// over atomic slots: lookups and inserts never lock and may run on several threads at once, while
+// reserve() and clear() must not race with them. Keys can be any 64-bit position hash (TicTacToe uses
+// its bitboards; larger games would use Zobrist keys).
+template<typename Node>
+class TranspositionTable {
+private:
+    static constexpr uint64_t EMPTY = ~0ull;
+    static constexpr size_t MIN_CAPACITY = 64;
+
+    struct Slot {
+        std::atomic<uint64_t> key{EMPTY};
+        std::atomic<Node *> node{nullptr};
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    size_t capacity = 0;
+    std::atomic<size_t> count{0};
+
+    [[nodiscard]] size_t home(uint64_t key) const {
+        return (key * 0x9E3779B97F4A7C15ull) >> 32 & (capacity - 1);
+    }
+
+public:
+    TranspositionTable() = default;
+
+    TranspositionTable(const TranspositionTable &) = delete;
+
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+    // Grows the table, keeping its entries, so that entries nodes fit at a load of at most one half.
+    void reserve(size_t entries) {
+        size_t wanted = MIN_CAPACITY;
+        while (wanted < 2 * entries) {
+            wanted *= 2;
+        }
+        if (wanted <= capacity) {
+            return;
+        }
+
+        std::unique_ptr<Slot[]> old = std::move(slots);
+        size_t old_capacity = capacity;
+        slots = std::make_unique<Slot[]>(wanted);
+        capacity = wanted;
+        count = 0;
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (Node *node = old[i].node.load(std::memory_order_relaxed)) {
+                insert(old[i].key.load(std::memory_order_relaxed), node);
+            }
+        }
+    }
+
+    // Forgets every entry and keeps the capacity.
+    void clear() {
+        for (size_t i = 0; i < capacity; ++i) {
+            slots[i].key.store(EMPTY, std::memory_order_relaxed);
+            slots[i].node.store(nullptr, std::memory_order_relaxed);
+        }
+        count = 0;
+    }
+
+    // The node stored for key, or nullptr.
+    [[nodiscard]] Node *find(uint64_t key) const {
+        for (size_t i = home(key), probes = 0; probes < capacity; i = (i + 1) & (capacity - 1), ++probes) {
+            uint64_t stored = slots[i].key.load(std::memory_order_acquire);
+            if (stored == key) {
+                return slots[i].node.load(std::memory_order_acquire);
+            }
+            if (stored == EMPTY) {
+                return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    // The node to use for key: the one already stored, or node after storing it. node is returned
+    // unstored when the table is three quarters full or when another thread has claimed key and not
+    // yet published its node; the position is then simply not shared.
+    Node *insert(uint64_t key, Node *node) {
+        if (capacity == 0 || count.load(std::memory_order_relaxed) >= capacity / 4 * 3) {
+            return node;
+        }
+        for (size_t i = home(key);; i = (i + 1) & (capacity - 1)) {
+            uint64_t stored = slots[i].key.load(std::memory_order_acquire);
+            if (stored == EMPTY && slots[i].key.compare_exchange_strong(stored, key, std::memory_order_acq_rel)) {
+                slots[i].node.store(node, std::memory_order_release);
+                count.fetch_add(1, std::memory_order_relaxed);
+                return node;
+            }
+            if (stored == key) {
+                Node *existing = slots[i].node.load(std::memory_order_acquire);
+                return existing ? existing : node;
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    // Slots allocated, used or not.
+    [[nodiscard]] size_t slotCount() const {
+        return capacity;
+    }
+};
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include "Game.h"
+#include "Planes.h"
+#include "Tensor4D.h"
+
+// Ultimate Tic-Tac-Toe: nine TicTacToe sub-boards in a 3x3 macro-board. A move in cell c of a
+// sub-board sends the opponent to sub-board c, or anywhere when that sub-board is already won or
+// full. Winning a sub-board claims its square of the macro-board, and three claimed squares in a
+// line win the game; when every sub-board is closed without that, the game is drawn.
+//
+// Each player holds one 9-bit bitboard per sub-board plus a 9-bit macro-board of the sub-boards they
+// won, so a move touches two words and wins are found with one table lookup each. Actions are
+// numbered sub_board * 9 + cell, which makes the legal moves a 128-bit mask built from shifted
+// sub-board masks.
+struct UltimateTicTacToe {
+    static constexpr size_t ACTION_SIZE = 81;
+    static constexpr size_t MAX_GAME_LENGTH = 81;
+    static constexpr size_t PLANES = 5;
+    static constexpr size_t HEIGHT = 9;
+    static constexpr size_t WIDTH = 9;
+
+    using MoveMask = unsigned __int128;
+
+    static constexpr uint16_t SUB_BOARD_MASK = 511;
+    static constexpr int8_t ANY_SUB_BOARD = -1;
+
+    // WINNING[board] tells whether a 3x3 bitboard holds a complete line.
+    static constexpr std::array<bool, SUB_BOARD_MASK + 1> WINNING = [] {
+        constexpr std::array<uint16_t, 8> lines = {0b000000111, 0b000111000, 0b111000000, 0b001001001,
+                                                   0b010010010, 0b100100100, 0b100010001, 0b001010100};
+        std::array<bool, SUB_BOARD_MASK + 1> winning{};
+        for (int board = 0; board <= SUB_BOARD_MASK; ++board) {
+            for (uint16_t line: lines) {
+                winning[board] = winning[board] || (board & line) == line;
+            }
+        }
+        return winning;
+    }();
+
+private:
+    enum class Outcome : uint8_t {
+        running,
+        won,  // by the player who made the last move
+        draw
+    };
+
+    // Zobrist keys from a fixed splitmix64 stream: one per player and action, and one per value of
+    // the forced sub-board.
+    struct ZobristKeys {
+        std::array<std::array<uint64_t, ACTION_SIZE>, 2> stones;
+        std::array<uint64_t, 10> active;
+    };
+
+    static constexpr ZobristKeys ZOBRIST = [] {
+        uint64_t state = 0x2545F4914F6CDD1Dull;
+        auto next = [&state] {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        };
+        ZobristKeys keys{};
+        for (auto &player: keys.stones) {
+            for (uint64_t &key: player) {
+                key = next();
+            }
+        }
+        for (uint64_t &key: keys.active) {
+            key = next();
+        }
+        return keys;
+    }();
+
+    std::array<std::array<uint16_t, 9>, 2> boards{};
+    // Sub-boards won by each player.
+    std::array<uint16_t, 2> macro{};
+    // Sub-boards that take no more moves, won or full.
+    uint16_t closed = 0;
+    int8_t active = ANY_SUB_BOARD;
+    uint8_t player = 0;
+    Outcome outcome = Outcome::running;
+    uint64_t key = ZOBRIST.active[0];
+
+    [[nodiscard]] uint16_t emptyCells(int board) const {
+        return ~(boards[0][board] | boards[1][board]) & SUB_BOARD_MASK;
+    }
+
+    // Row row of the 9x9 board as nine bits, column by column, gathered from the sub-board rows of
+    // one band of three sub-boards.
+    static uint32_t boardRow(const std::array<uint16_t, 9> &sub_boards, size_t row) {
+        const size_t band = row / 3 * 3;
+        const size_t shift = row % 3 * 3;
+        return (sub_boards[band] >> shift & 7) | (sub_boards[band + 1] >> shift & 7) << 3 |
+               (sub_boards[band + 2] >> shift & 7) << 6;
+    }
+
+    // Calls visit with every action set in mask, in increasing order, one 64-bit half at a time.
+    template<typename Visit>
+    static void forEachMove(MoveMask mask, Visit &&visit) {
+        for (int half = 0; half < 2; ++half) {
+            for (uint64_t bits = static_cast<uint64_t>(mask >> (64 * half)); bits; bits &= bits - 1) {
+                visit(static_cast<uint8_t>(64 * half + __builtin_ctzll(bits)));
+            }
+        }
+    }
+
+public:
+    // Plays action sub_board * 9 + cell for the player to move. The move must be legal.
+    void makeMove(uint8_t move) {
+        const int board = move / 9;
+        const int cell = move % 9;
+        uint16_t &stones = boards[player][board];
+        stones |= static_cast<uint16_t>(1 << cell);
+        key ^= ZOBRIST.stones[player][move] ^ ZOBRIST.active[active + 1];
+
+        if (WINNING[stones]) {
+            macro[player] |= static_cast<uint16_t>(1 << board);
+            closed |= static_cast<uint16_t>(1 << board);
+            if (WINNING[macro[player]]) {
+                outcome = Outcome::won;
+            }
+        } else if ((stones | boards[1 - player][board]) == SUB_BOARD_MASK) {
+            closed |= static_cast<uint16_t>(1 << board);
+        }
+        if (outcome == Outcome::running && closed == SUB_BOARD_MASK) {
+            outcome = Outcome::draw;
+        }
+
+        active = closed >> cell & 1 ? ANY_SUB_BOARD : static_cast<int8_t>(cell);
+        key ^= ZOBRIST.active[active + 1];
+        player ^= 1;
+    }
+
+    // Bit a is set when action a is legal; empty once the game is over.
+    [[nodiscard]] MoveMask legalMask() const {
+        if (outcome != Outcome::running) {
+            return 0;
+        }
+        if (active != ANY_SUB_BOARD) {
+            return static_cast<MoveMask>(emptyCells(active)) << (9 * active);
+        }
+        MoveMask mask = 0;
+        for (int board = 0; board < 9; ++board) {
+            if (!(closed >> board & 1)) {
+                mask |= static_cast<MoveMask>(emptyCells(board)) << (9 * board);
+            }
+        }
+        return mask;
+    }
+
+    [[nodiscard]] std::array<uint8_t, ACTION_SIZE> getLegalMoves() const {
+        std::array<uint8_t, ACTION_SIZE> legal_moves{};
+        forEachMove(legalMask(), [&](uint8_t move) { legal_moves[move] = 1; });
+        return legal_moves;
+    }
+
+    [[nodiscard]] int CountLegalMoves() const {
+        const MoveMask mask = legalMask();
+        return __builtin_popcountll(static_cast<uint64_t>(mask)) +
+               __builtin_popcountll(static_cast<uint64_t>(mask >> 64));
+    }
+
+    // Planes of the 9x9 board, sub-board b covering rows 3 * (b / 3) on and columns 3 * (b % 3) on:
+    // the stones of the player to move, the opponent's stones, the legal moves, and the sub-boards
+    // won by the player to move and by the opponent, filled in whole. Every plane is written a row
+    // at a time, nine bits gathered from three sub-boards and expanded at once.
+    void encode(float *planes) const {
+        const MoveMask mask = legalMask();
+        std::array<std::array<uint16_t, 9>, PLANES> sources{};
+        sources[0] = boards[player];
+        sources[1] = boards[1 - player];
+        for (size_t board = 0; board < 9; ++board) {
+            sources[2][board] = static_cast<uint16_t>(mask >> (9 * board)) & SUB_BOARD_MASK;
+            sources[3][board] = macro[player] >> board & 1 ? SUB_BOARD_MASK : 0;
+            sources[4][board] = macro[1 - player] >> board & 1 ? SUB_BOARD_MASK : 0;
+        }
+        for (size_t plane = 0; plane < PLANES; ++plane) {
+            for (size_t row = 0; row < HEIGHT; ++row) {
+                expandBits(boardRow(sources[plane], row), planes + (plane * HEIGHT + row) * WIDTH);
+            }
+        }
+    }
+
+    [[nodiscard]] nnm::Tensor4D getEncodedState() const {
+        nnm::Tensor4D tensor(1, PLANES, HEIGHT, WIDTH);
+        encode(tensor.getData().data());
+        return tensor;
+    }
+
+    // 1 when the player who made the last move has won, 0 for a draw or a running game.
+    [[nodiscard]] std::pair<float, bool> getValueAndTerminated() const {
+        switch (outcome) {
+            case Outcome::won:
+                return {1.0f, true};
+            case Outcome::draw:
+                return {0.0f, true};
+            default:
+                return {0.0f, false};
+        }
+    }
+
+    [[nodiscard]] bool isRunning() const {
+        return outcome == Outcome::running;
+    }
+
+    // Zobrist hash of the stones and the forced sub-board, updated incrementally by makeMove. The
+    // player to move and the outcome follow from the stones.
+    [[nodiscard]] uint64_t getKey() const {
+        return key;
+    }
+
+    bool operator==(const UltimateTicTacToe &) const = default;
+
+    // 0 for the first player, 1 for the second.
+    [[nodiscard]] int getCurrentPlayer() const {
+        return player;
+    }
+
+    // The sub-board the next move must be played in, or ANY_SUB_BOARD.
+    [[nodiscard]] int activeSubBoard() const {
+        return active;
+    }
+
+    // Sub-boards won by player, as a macro-board bitboard.
+    [[nodiscard]] uint16_t wonSubBoards(int side) const {
+        return macro[side];
+    }
+
+    // Number of move sequences of length depth, counting a game that ends earlier as no sequence,
+    // like chess perft. The last ply is counted from the legal-move mask without being played.
+    static uint64_t perft(const UltimateTicTacToe &game, int depth) {
+        if (depth == 0) {
+            return 1;
+        }
+        if (depth == 1) {
+            return static_cast<uint64_t>(game.CountLegalMoves());
+        }
+        uint64_t nodes = 0;
+        forEachMove(game.legalMask(), [&](uint8_t move) {
+            UltimateTicTacToe next = game;
+            next.makeMove(move);
+            nodes += perft(next, depth - 1);
+        });
+        return nodes;
+    }
+
+    void printBoard() const {
+        for (size_t row = 0; row < HEIGHT; ++row) {
+            if (row > 0 && row % 3 == 0) {
+                std::cout << "------+-------+------" << std::endl;
+            }
+            for (size_t column = 0; column < WIDTH; ++column) {
+                if (column > 0 && column % 3 == 0) {
+                    std::cout << "| ";
+                }
+                const int board = static_cast<int>(row / 3 * 3 + column / 3);
+                const int cell = static_cast<int>(row % 3 * 3 + column % 3);
+                if (boards[0][board] >> cell & 1) {
+                    std::cout << "X ";
+                } else if (boards[1][board] >> cell & 1) {
+                    std::cout << "O ";
+                } else {
+                    std::cout << ". ";
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+};
+
+static_assert(Game<UltimateTicTacToe>);
@@ -7,34 +7,99 @@
 #include <random>
 #include <algorithm>
 #include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include "BatchScheduler.h"
+#include "Game.h"
 #include "TicTacToe.h"
 #include "TicTacToeModel.h"
 #include "MCTSLearn.h"
-
+#include "PrecomputedEvaluator.h"
+#include "Solver.h"
+#include "TorchEvaluator.h"
+
+// Self-play training for any Game with a libtorch Model (a module holder whose forward returns
+// policies over G's actions and values). The native runtime, the precomputed position table and the
+// solver gate only exist for TicTacToe with its model; other games search on libtorch.
+template<Game G = TicTacToe, typename Model = TicTacToeModel>
 class AlphaZero {
 private:
-    TicTacToeModel _model;
+    static constexpr bool TIC_TAC_TOE = std::is_same_v<G, TicTacToe> && std::is_same_v<Model, TicTacToeModel>;
+
+    Model _model;
     torch::optim::Optimizer &optimizer;
-    TicTacToe game;
+    G game;
     std::map<std::string, float> args;
-    MCTSLearn mcts;
+    MCTSLearn<G> mcts;
+    // Read from args once, because self-play games run concurrently and must not index the map.
+    int num_searches;
+    float temperature;
+    bool reuse_tree;
+    // Native copies of the models being searched with, refreshed from the torch weights.
+    nnm::TicTacToeModel native_model;
+    nnm::TicTacToeModel native_opponent;
+    // Evaluations of the current weights, shared by the self-play games and by the new model's side
+    // of evaluateModels. Null when args["evaluation_cache_size"] is 0.
+    std::unique_ptr<EvaluationCache<G>> evaluation_cache;
+
+    bool enabled(const std::string &name) {
+        return args.count(name) && args[name] != 0;
+    }
 
-    std::vector<std::tuple<at::Tensor, std::vector<float>, float>> selfPlayParallel(int num_games) {
-        std::vector<std::thread> threads;
-        std::vector<std::vector<std::tuple<at::Tensor, std::vector<float>, float>>> thread_memories(num_games);
+    bool precomputedSearch() {
+        return TIC_TAC_TOE && enabled("precomputed_search");
+    }
 
-        for (int i = 0; i < num_games; ++i) {
-            threads.emplace_back([this, i, &thread_memories]() {
-                thread_memories[i] = this->selfPlaySingle();
-            });
+    // Searches run on the nnm runtime when args["native_search"] is set, copying the current torch
+    // weights first, and on libtorch on the model's device otherwise. With args["precomputed_search"]
+    // the model evaluates every position once up front and searches read the resulting table.
+    std::unique_ptr<Evaluator<G>> makeEvaluator(Model &model, nnm::TicTacToeModel &native) {
+        std::unique_ptr<Evaluator<G>> evaluator;
+        if constexpr (TIC_TAC_TOE) {
+            if (enabled("native_search")) {
+                copyWeights(model, native);
+                evaluator = std::make_unique<NnmEvaluator<nnm::TicTacToeModel>>(native);
+            }
         }
+        if (!evaluator) {
+            evaluator = std::make_unique<TorchEvaluator<G, Model>>(model, model->parameters()[0].device());
+        }
+        if constexpr (TIC_TAC_TOE) {
+            if (precomputedSearch()) {
+                return std::make_unique<PrecomputedEvaluator>(*evaluator);
+            }
+        }
+        return evaluator;
+    }
 
-        for (auto &thread: threads) {
-            thread.join();
+    // Simulations that bring the root up to num_searches visits; a reused subtree already has some.
+    int newSimulations(const SearchTree<G> &tree) {
+        return std::max(1, num_searches - tree.root()->visits());
+    }
+
+    // Moves the search tree past a played move. The subtree is kept unless args["reuse_tree"] is 0.
+    void advanceTree(SearchTree<G> &tree, uint8_t move, const G &next) {
+        if (!reuse_tree) {
+            tree.reset(next);
+        } else {
+            tree.advance(move);
+        }
+    }
+
+    // Plays num_games games as coroutines on the scheduler, which evaluates the leaves of every game
+    // searching at the time in one batch.
+    std::vector<std::tuple<at::Tensor, std::vector<float>, float>> selfPlayConcurrent(int num_games,
+                                                                                       BatchScheduler<G> &scheduler,
+                                                                                       int num_threads) {
+        std::vector<std::vector<std::tuple<at::Tensor, std::vector<float>, float>>> game_memories(num_games);
+        for (int i = 0; i < num_games; ++i) {
+            scheduler.spawn(selfPlayGame(scheduler, game_memories[i]));
         }
+        scheduler.run(num_threads);
 
         std::vector<std::tuple<at::Tensor, std::vector<float>, float>> combined_memory;
-        for (const auto &memory: thread_memories) {
+        for (const auto &memory: game_memories) {
             combined_memory.insert(combined_memory.end(), memory.begin(), memory.end());
         }
 
@@ -54,19 +119,30 @@ private:
     }
 
 
-    std::vector<std::tuple<at::Tensor, std::vector<float>, float>> selfPlaySingle() {
-        std::vector<std::tuple<at::Tensor, std::vector<float>, Player>> memory;
-        Player player = Player::x;
-        TicTacToe state = game;
+    // One self-play game, suspending whenever its search needs leaves evaluated. Its samples are
+    // written to result when the game ends.
+    typename BatchScheduler<G>::Task selfPlayGame(BatchScheduler<G> &scheduler,
+                                                  std::vector<std::tuple<at::Tensor, std::vector<float>, float>> &result) {
+        // Players are 1 and -1, the first to move being 1.
+        std::vector<std::tuple<at::Tensor, std::vector<float>, int>> memory;
+        int player = 1;
+        G state = game;
+        SearchTree<G> tree(state);
+        std::mt19937 gen(std::random_device{}());
 
         while (true) {
-            TicTacToe neutral_state = state;
-            std::vector<float> action_probs = mcts.search(neutral_state, _model, args["num_searches"]);
-            memory.emplace_back(neutral_state.getTorchEncodedState(), action_probs, player);
+            G neutral_state = state;
+            typename MCTSLearn<G>::Search search(mcts, tree, scheduler.cache(), newSimulations(tree),
+                                                 &scheduler.backend());
+            while (!search.finished()) {
+                search.complete(co_await scheduler.evaluate(search.collect()));
+            }
+            std::vector<float> action_probs = MCTSLearn<G>::visitDistribution(*tree.root());
+            memory.emplace_back(torchEncodedState(neutral_state), action_probs, player);
 
-            std::array<float, 9> legal_temperature_probs = {0};
-            for (int move = 0; move < 9; ++move) {
-                legal_temperature_probs[move] = std::pow(action_probs[move], 1.0f / args["temperature"]);
+            std::array<float, G::ACTION_SIZE> legal_temperature_probs = {0};
+            for (size_t move = 0; move < G::ACTION_SIZE; ++move) {
+                legal_temperature_probs[move] = std::pow(action_probs[move], 1.0f / temperature);
             }
 
             float sum = std::accumulate(legal_temperature_probs.begin(), legal_temperature_probs.end(), 0.0f);
@@ -75,23 +151,22 @@ private:
             }
 
             std::discrete_distribution<> dist(legal_temperature_probs.begin(), legal_temperature_probs.end());
-            std::mt19937 gen(std::random_device{}());
             int action = dist(gen);
 
             state.makeMove(action);
+            advanceTree(tree, action, state);
 
             auto [value, is_terminal] = state.getValueAndTerminated();
 
             if (is_terminal) {
-                std::vector<std::tuple<at::Tensor, std::vector<float>, float>> returnMemory;
                 for (const auto &[hist_neutral_state, hist_action_probs, hist_player]: memory) {
                     float hist_outcome = (hist_player == player) ? value : -value;
-                    returnMemory.emplace_back(hist_neutral_state, hist_action_probs, hist_outcome);
+                    result.emplace_back(hist_neutral_state, hist_action_probs, hist_outcome);
                 }
-                return returnMemory;
+                co_return;
             }
 
-            player = (player == Player::x) ? Player::o : Player::x;
+            player = -player;
         }
     }
 
@@ -121,8 +196,8 @@ private:
             auto [policy_output, value_output] = _model(state_batch);
 
             // Calculate loss
-            auto policy_loss = torch::nn::functional::cross_entropy(policy_output, policy_target_batch);
-            auto value_loss = torch::nn::functional::mse_loss(value_output, value_target_batch);
+            torch::Tensor policy_loss = torch::nn::functional::cross_entropy(policy_output, policy_target_batch);
+            torch::Tensor value_loss = torch::nn::functional::mse_loss(value_output, value_target_batch);
 
             // L2 regularization
             float l2_reg = args["l2_reg"];
@@ -131,7 +206,7 @@ private:
                 l2_loss += torch::sum(torch::pow(p, 2));
             }
 
-            auto total_loss = policy_loss + value_loss + l2_reg * l2_loss;
+            torch::Tensor total_loss = policy_loss + value_loss + l2_reg * l2_loss;
 
             // Backward pass and optimization
             optimizer.zero_grad();
@@ -150,39 +225,89 @@ private:
         }
     }
 
-    float evaluateModels(TicTacToeModel &new_model, TicTacToeModel &old_model, int num_games) {
+    // Grades the new model against perfect play instead of against the best model, which takes
+    // milliseconds rather than eval_games searched games. The gate remembers the best model's score,
+    // so only the new model is evaluated; like evaluateModels, the result is at least 0.5 exactly
+    // when the new model does at least as well, here by move accuracy.
+    float gradeModels(Model &new_model, SolverGate &gate) requires TIC_TAC_TOE {
+        std::unique_ptr<Evaluator<G>> new_evaluator = makeEvaluator(new_model, native_model);
+        const float best_accuracy = gate.best().move_accuracy;
+        PolicyScore new_score;
+        float result = gate.offer(*new_evaluator, new_score);
+
+        std::cout << "Solver grading over " << new_score.positions << " positions: "
+                  << "new model move accuracy " << new_score.move_accuracy
+                  << ", optimal mass " << new_score.optimal_mass
+                  << ", value error " << new_score.value_error
+                  << "; best model move accuracy " << best_accuracy << std::endl;
+
+        return result;
+    }
+
+    // A copy of model's weights and buffers in a module of its own. Model is a module holder, so
+    // copying the holder would share the module and see every later training step.
+    static Model snapshot(Model &model) {
+        torch::NoGradGuard no_grad;
+        Model copy;
+        copy->to(model->parameters()[0].device());
+        auto parameters = copy->named_parameters();
+        for (const auto &parameter: model->named_parameters()) {
+            parameters[parameter.key()].copy_(parameter.value());
+        }
+        auto buffers = copy->named_buffers();
+        for (const auto &buffer: model->named_buffers()) {
+            buffers[buffer.key()].copy_(buffer.value());
+        }
+        return copy;
+    }
+
+    float evaluateModels(Model &new_model, Model &old_model, int num_games) {
         int new_model_wins = 0;
         int old_model_wins = 0;
         int draws = 0;
+        std::unique_ptr<Evaluator<G>> new_evaluator = makeEvaluator(new_model, native_model);
+        if (!precomputedSearch()) {
+            new_evaluator->setCache(evaluation_cache.get());
+        }
+        std::unique_ptr<Evaluator<G>> old_evaluator = makeEvaluator(old_model, native_opponent);
+        // Games are played one after another here, so each search can use several threads.
+        size_t search_threads = args.count("search_threads") ? static_cast<size_t>(args["search_threads"]) : 1;
 
         for (int i = 0; i < num_games; ++i) {
-            TicTacToe state = game;
-            Player current_player = Player::x;
-            bool new_model_is_x = (i % 2 == 0);  // Alternate starting player
+            G state = game;
+            bool new_to_move = (i % 2 == 0);  // Alternate starting player
+            // One tree per model, since their statistics come from different networks.
+            SearchTree<G> new_tree(state), old_tree(state);
 
             while (true) {
-                TicTacToeModel &current_model = (new_model_is_x == (current_player == Player::x)) ? new_model
-                                                                                                  : old_model;
-                std::vector<float> action_probs = mcts.search(state, current_model, args["num_searches"]);
+                Evaluator<G> &current_evaluator = new_to_move ? *new_evaluator : *old_evaluator;
+                SearchTree<G> &tree = new_to_move ? new_tree : old_tree;
+                std::vector<float> action_probs =
+                        search_threads > 1
+                        ? mcts.searchParallel(tree, current_evaluator, newSimulations(tree), search_threads)
+                        : mcts.search(tree, current_evaluator, newSimulations(tree));
 
                 int action = std::distance(action_probs.begin(),
                                            std::max_element(action_probs.begin(), action_probs.end()));
                 state.makeMove(action);
+                advanceTree(new_tree, action, state);
+                advanceTree(old_tree, action, state);
 
                 auto [value, is_terminal] = state.getValueAndTerminated();
 
                 if (is_terminal) {
+                    // The value is for the model that just moved.
                     if (value == 1) {
-                        new_model_is_x ? ++new_model_wins : ++old_model_wins;
+                        new_to_move ? ++new_model_wins : ++old_model_wins;
                     } else if (value == -1) {
-                        new_model_is_x ? ++old_model_wins : ++new_model_wins;
+                        new_to_move ? ++old_model_wins : ++new_model_wins;
                     } else {
                         ++draws;
                     }
                     break;
                 }
 
-                current_player = (current_player == Player::x) ? Player::o : Player::x;
+                new_to_move = !new_to_move;
             }
         }
 
@@ -197,14 +322,44 @@ private:
 
 
 public:
-    AlphaZero(TicTacToeModel &model, torch::optim::Optimizer &optimizer,
-              TicTacToe game, std::map<std::string, float> args)
+    AlphaZero(Model &model, torch::optim::Optimizer &optimizer, G game, std::map<std::string, float> args)
             : _model(std::move(model)), optimizer(optimizer), game(game), args(args),
-              mcts(args["dirichlet_epsilon"], args["dirichlet_alpha"]) {}
+              mcts(args["dirichlet_epsilon"], args["dirichlet_alpha"]),
+              num_searches(static_cast<int>(args.at("num_searches"))), temperature(args.at("temperature")),
+              reuse_tree(!args.count("reuse_tree") || args.at("reuse_tree") != 0) {
+        if constexpr (!TIC_TAC_TOE) {
+            for (const char *option: {"native_search", "precomputed_search", "solver_gate"}) {
+                if (enabled(option)) {
+                    throw std::invalid_argument(std::string(option) + " is only available for TicTacToe");
+                }
+            }
+        }
+        if (args.count("search_batch_size")) {
+            mcts.setBatchSize(static_cast<size_t>(args["search_batch_size"]),
+                              args.count("adaptive_search_batch") && args["adaptive_search_batch"] != 0);
+        }
+        if (args.count("transpositions")) {
+            mcts.setTranspositions(args["transpositions"] != 0);
+        }
+        if (args.count("symmetries")) {
+            mcts.setSymmetries(args["symmetries"] != 0);
+        }
+        size_t cache_size = args.count("evaluation_cache_size") ? static_cast<size_t>(args["evaluation_cache_size"])
+                                                                : 1 << 16;
+        if (cache_size > 0) {
+            evaluation_cache = std::make_unique<EvaluationCache<G>>(cache_size);
+        }
+    }
 
     void learn() {
-        TicTacToeModel best_model = _model;
+        Model best_model = snapshot(_model);
         float best_score = 0.0f;
+        std::optional<SolverGate> gate;
+        if constexpr (TIC_TAC_TOE) {
+            if (enabled("solver_gate")) {
+                gate.emplace(*makeEvaluator(_model, native_model));
+            }
+        }
 
         for (int iteration = 0; iteration < args["num_iterations"]; ++iteration) {
             std::cout << "Iteration " << iteration + 1 << "/" << args["num_iterations"] << std::flush << std::endl;
@@ -212,26 +367,44 @@ public:
             std::vector<std::tuple<at::Tensor, std::vector<float>, float>> memory;
 
             _model->eval();
+            std::unique_ptr<Evaluator<G>> evaluator = makeEvaluator(_model, native_model);
+            if (!precomputedSearch()) {
+                evaluator->setCache(evaluation_cache.get());
+            }
             int num_threads = determineOptimalThreadCount();
-            int games_per_thread = std::max(1, static_cast<int>(args["num_selfPlay_iterations"]) / num_threads);
-            int total_games = num_threads * games_per_thread;
+            int total_games = std::max(1, static_cast<int>(args["num_selfPlay_iterations"]));
+            int concurrent_games = args.count("concurrent_games")
+                                   ? std::max(1, static_cast<int>(args["concurrent_games"])) : 256;
+            BatchScheduler<G> scheduler(*evaluator);
 
-            std::cout << "Starting " << total_games << " self-play games on " << num_threads << " threads..."
-                      << std::endl;
+            std::cout << "Starting " << total_games << " self-play games, " << concurrent_games << " at a time on "
+                      << num_threads << " threads..." << std::endl;
 
-            for (int i = 0; i < total_games; i += num_threads) {
-                int games_this_batch = std::min(num_threads, total_games - i);
-                auto batch_memory = selfPlayParallel(games_this_batch);
+            for (int i = 0; i < total_games; i += concurrent_games) {
+                int games_this_batch = std::min(concurrent_games, total_games - i);
+                auto batch_memory = selfPlayConcurrent(games_this_batch, scheduler, num_threads);
                 memory.insert(memory.end(), batch_memory.begin(), batch_memory.end());
                 std::cout << "Completed " << i + games_this_batch << "/" << total_games << " games" << std::endl;
             }
 
             std::cout << "Self-play completed. Total samples: " << memory.size() << std::flush << std::endl;
+            if (scheduler.forwards() > 0) {
+                std::cout << "Average evaluation batch: "
+                          << static_cast<float>(scheduler.evaluated()) / static_cast<float>(scheduler.forwards())
+                          << " positions" << std::endl;
+            }
+            if (evaluation_cache && !precomputedSearch()) {
+                std::cout << "Evaluation cache hit rate: " << 100.0f * evaluation_cache->hitRate() << "%" << std::endl;
+                evaluation_cache->resetCounters();
+            }
 
             _model->train();
             for (int epoch = 0; epoch < args["num_epochs"]; ++epoch) {
                 train(memory);
             }
+            if (evaluation_cache) {
+                evaluation_cache->invalidate();
+            }
 
             std::cout << "Saving model for iteration " << iteration + 1 << std::flush << std::endl;
             torch::save(_model, "model_" + std::to_string(iteration) + ".pt");
@@ -239,14 +412,17 @@ public:
 
             std::cout << "Evaluating new model against best model..." << std::endl;
 
-            TicTacToeModel new_model_copy = _model;
-            TicTacToeModel best_model_copy = best_model;
-
-            float new_model_score = evaluateModels(new_model_copy, best_model_copy, args["eval_games"]);
+            float new_model_score;
+            if constexpr (TIC_TAC_TOE) {
+                new_model_score = gate ? gradeModels(_model, *gate)
+                                       : evaluateModels(_model, best_model, args["eval_games"]);
+            } else {
+                new_model_score = evaluateModels(_model, best_model, args["eval_games"]);
+            }
 
             if (new_model_score >= 0.5f) {
                 std::cout << "New best model found! Score: " << new_model_score << std::endl;
-                best_model = _model;
+                best_model = snapshot(_model);
                 best_score = new_model_score;
                 torch::save(best_model, "best_model.pt");
             } else {
@@ -0,0 +1,190 @@
+// Converts a libtorch TicTacToeModel checkpoint (as written by AlphaZero::learn) into an nnm weight
+// file, then runs both models on a batch of positions and fails if their outputs disagree. The torch
+// encodings of those positions are checked against the per-cell encoding first.
+//
+//   ExportWeights best_model.pt tictactoe.nnmw [--dtype f32|f16|bf16] [--fold-bn] [--positions N]
+//                                              [--tolerance T]
+
+#include <torch/torch.h>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "FoldBatchNorm.h"
+#include "TicTacToe.h"
+#include "TorchEvaluator.h"
+#include "WeightFile.h"
+
+namespace {
+
+    struct ExportOptions {
+        std::string checkpoint;
+        std::string output;
+        nnm::DType dtype = nnm::DType::F32;
+        bool fold_bn = false;
+        size_t positions = 256;
+        float tolerance = -1.0f;
+    };
+
+    float defaultTolerance(nnm::DType dtype) {
+        switch (dtype) {
+            case nnm::DType::F32:
+                return 1e-4f;
+            case nnm::DType::F16:
+                return 1e-2f;
+            case nnm::DType::BF16:
+                return 5e-2f;
+        }
+        return 1e-4f;
+    }
+
+    ExportOptions parseArguments(int argc, char **argv) {
+        ExportOptions options;
+        std::vector<std::string> positional;
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument(arg + " needs a value");
+                }
+                return argv[++i];
+            };
+            if (arg == "--dtype") {
+                options.dtype = nnm::dtype_from_name(value());
+            } else if (arg == "--fold-bn") {
+                options.fold_bn = true;
+            } else if (arg == "--positions") {
+                options.positions = std::stoul(value());
+            } else if (arg == "--tolerance") {
+                options.tolerance = std::stof(value());
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        if (positional.size() != 2) {
+            throw std::invalid_argument("usage: ExportWeights <checkpoint.pt> <output.nnmw> [--dtype f32|f16|bf16]"
+                                        " [--fold-bn] [--positions N] [--tolerance T]");
+        }
+        options.checkpoint = positional[0];
+        options.output = positional[1];
+        if (options.tolerance < 0.0f) {
+            options.tolerance = defaultTolerance(options.dtype);
+        }
+        return options;
+    }
+
+    // Positions reached by random play, so the parity check covers realistic inputs.
+    std::vector<TicTacToe> samplePositions(size_t count) {
+        std::mt19937 gen(42);
+        std::vector<TicTacToe> positions;
+        while (positions.size() < count) {
+            TicTacToe game;
+            while (game.isRunning() && positions.size() < count) {
+                positions.push_back(game);
+                auto legal = game.getLegalMoves();
+                std::vector<uint8_t> moves;
+                for (uint8_t m = 0; m < 9; ++m) {
+                    if (legal[m]) moves.push_back(m);
+                }
+                game.makeMove(moves[std::uniform_int_distribution<size_t>(0, moves.size() - 1)(gen)]);
+            }
+        }
+        return positions;
+    }
+
+    // The planes as the per-cell encoding wrote them before positions were encoded into raw storage:
+    // side to move, opponent, empty, set one cell at a time through tensor indexing.
+    torch::Tensor perCellEncoding(const TicTacToe &game) {
+        torch::Tensor planes = torch::zeros({3, 3, 3});
+        const uint64_t key = game.getKey();
+        const int own = game.getCurrentPlayer() == Player::x ? 0 : 1;
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                const int cell = i * 3 + j;
+                if (key >> cell & 1) {
+                    planes[own][i][j] = 1.0f;
+                } else if (key >> (9 + cell) & 1) {
+                    planes[1 - own][i][j] = 1.0f;
+                } else {
+                    planes[2][i][j] = 1.0f;
+                }
+            }
+        }
+        return planes;
+    }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    try {
+        ExportOptions options = parseArguments(argc, argv);
+        torch::NoGradGuard no_grad;
+
+        TicTacToeModel model("cpu");
+        torch::load(model, options.checkpoint);
+        model->eval();
+
+        // Only conv and linear weights are packed; biases and normalization stay float.
+        std::map<std::string, nnm::Tensor4D> state;
+        std::map<std::string, nnm::DType> dtypes;
+        for (const auto &[name, tensor]: stateDict(model)) {
+            if (name.ends_with("num_batches_tracked")) {
+                continue;
+            }
+            state.emplace(name, toTensor4D(tensor));
+            dtypes[name] = tensor.dim() >= 2 ? options.dtype : nnm::DType::F32;
+        }
+        if (options.fold_bn) {
+            nnm::fold_batch_norm(state, "conv1", "bn1");
+        }
+
+        nnm::WeightFileWriter writer;
+        for (const auto &[name, tensor]: state) {
+            writer.add(name, tensor, dtypes.count(name) ? dtypes.at(name) : nnm::DType::F32);
+        }
+        writer.write(options.output);
+
+        nnm::TicTacToeModel native(options.output);
+        std::vector<TicTacToe> positions = samplePositions(options.positions);
+        std::vector<torch::Tensor> encoded, reference;
+        for (const auto &position: positions) {
+            encoded.push_back(torchEncodedState(position));
+            reference.push_back(perCellEncoding(position));
+        }
+        torch::Tensor batch = torchEncodedBatch(positions.data(), positions.size());
+        if (!torch::equal(torch::stack(encoded), torch::stack(reference)) ||
+            !torch::equal(batch, torch::stack(reference))) {
+            std::cerr << "Encoding parity check failed" << std::endl;
+            return 1;
+        }
+        auto [torch_policy, torch_value] = model->forward(batch);
+
+        float policy_error = 0.0f, value_error = 0.0f;
+        for (size_t i = 0; i < positions.size(); ++i) {
+            auto [policy, value] = native.forward(positions[i].getEncodedState());
+            auto index = static_cast<int64_t>(i);
+            for (int64_t a = 0; a < 9; ++a) {
+                policy_error = std::max(policy_error, std::abs(policy(0, a, 0, 0) -
+                                                               torch_policy[index][a].item<float>()));
+            }
+            value_error = std::max(value_error, std::abs(value(0, 0, 0, 0) - torch_value[index][0].item<float>()));
+        }
+
+        std::cout << "Wrote " << options.output << " (" << nnm::dtype_name(options.dtype)
+                  << (options.fold_bn ? ", batch norm folded" : "") << ", " << native.weight_bytes()
+                  << " bytes of parameters)" << std::endl;
+        std::cout << "Parity over " << positions.size() << " positions: max policy error " << policy_error
+                  << ", max value error " << value_error << " (tolerance " << options.tolerance << ")" << std::endl;
+
+        if (policy_error > options.tolerance || value_error > options.tolerance) {
+            std::cerr << "Parity check failed" << std::endl;
+            return 1;
+        }
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -4,7 +4,7 @@
 
 class TicTacToeModelImpl : public torch::nn::Module {
 public:
-    TicTacToeModelImpl(const std::string &device = "cuda") : device_(device) {
+    TicTacToeModelImpl(const std::string &device = "cpu") : device_(device) {
         conv1 = register_module("conv1", torch::nn::Conv2d(torch::nn::Conv2dOptions(3, 16, 3).padding(1)));
         bn1 = register_module("bn1", torch::nn::BatchNorm2d(16));
         pool = register_module("pool", torch::nn::MaxPool2d(torch::nn::MaxPool2dOptions(2).stride(2)));
@@ -15,13 +15,8 @@ public:
         this->to(torch::Device(device_));
     }
 
-    std::pair<torch::Tensor, torch::Tensor> forward(torch::Tensor x, bool eval_mode = false) {
-        if (eval_mode) {
-            this->eval();
-        } else {
-            this->train();
-        }
-
+    // Runs in whatever mode the module is in; callers switch it with train() and eval().
+    std::pair<torch::Tensor, torch::Tensor> forward(torch::Tensor x) {
         x = conv1->forward(x);
         x = bn1->forward(x);
         x = torch::relu(x);
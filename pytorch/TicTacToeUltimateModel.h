@@ -1,41 +1,37 @@
+#pragma once
+
 #include <torch/torch.h>
 
-class TicTacToeUltimateModel : public torch::nn::Module {
+// Policy over the 81 actions and value of an UltimateTicTacToe position, from its 5x9x9 planes.
+class TicTacToeUltimateModelImpl : public torch::nn::Module {
 public:
-    explicit TicTacToeUltimateModel(torch::Device device = torch::kCPU)
-            : conv1(torch::nn::Conv2d(torch::nn::Conv2dOptions(5, 8, 3).stride(1).padding(1))),
-              fc1(8 * 9 * 9, 64),
-              fc2(64, 81),
-              fc3(64, 1),
-              device(device) {
-        register_module("conv1", conv1);
-        register_module("fc1", fc1);
-        register_module("fc2", fc2);
-        register_module("fc3", fc3);
-        to(device);
-    }
+    TicTacToeUltimateModelImpl(const std::string &device = "cpu") : device_(device) {
+        conv1 = register_module("conv1", torch::nn::Conv2d(torch::nn::Conv2dOptions(5, 8, 3).stride(1).padding(1)));
+        fc1 = register_module("fc1", torch::nn::Linear(8 * 9 * 9, 64));
+        fc2 = register_module("fc2", torch::nn::Linear(64, 81));
+        fc3 = register_module("fc3", torch::nn::Linear(64, 1));
 
-    std::tuple<torch::Tensor, torch::Tensor> forward(torch::Tensor x, bool eval_mode = false) {
-        if (eval_mode) {
-            eval();
-        } else {
-            train();
-        }
+        this->to(torch::Device(device_));
+    }
 
-        x = torch::relu(conv1(x));
+    // Runs in whatever mode the module is in; callers switch it with train() and eval().
+    std::pair<torch::Tensor, torch::Tensor> forward(torch::Tensor x) {
+        x = torch::relu(conv1->forward(x));
         x = x.flatten(1);
-        x = torch::relu(fc1(x));
-        auto policy = fc2(x);
-        auto value = fc3(x);
+        x = torch::relu(fc1->forward(x));
+        auto policy = fc2->forward(x);
+        auto value = fc3->forward(x);
 
         policy = torch::softmax(policy, 1);
         value = torch::tanh(value);
 
-        return std::make_tuple(policy, value);
+        return {policy, value};
     }
 
 private:
-    torch::nn::Conv2d conv1;
-    torch::nn::Linear fc1, fc2, fc3;
-    torch::Device device;
-};
\ No newline at end of file
+    torch::nn::Conv2d conv1{nullptr};
+    torch::nn::Linear fc1{nullptr}, fc2{nullptr}, fc3{nullptr};
+    std::string device_;
+};
+
+TORCH_MODULE(TicTacToeUltimateModel);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <torch/torch.h>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "Evaluator.h"
+#include "TicTacToeModel.h"
+#include "../src/TicTacToeModel.h"
+
+// Shape of a batch of count encoded positions of G.
+template<Game G>
+std::vector<int64_t> encodedShape(size_t count) {
+    return {static_cast<int64_t>(count), static_cast<int64_t>(G::PLANES), static_cast<int64_t>(G::HEIGHT),
+            static_cast<int64_t>(G::WIDTH)};
+}
+
+// The input planes of a position as a (C, H, W) torch tensor, encoded into its storage. The tensor
+// is created on the CPU, where a fresh tensor is contiguous in (C, H, W) order as encode() writes.
+template<Game G>
+torch::Tensor torchEncodedState(const G &game) {
+    torch::Tensor state = torch::empty({static_cast<int64_t>(G::PLANES), static_cast<int64_t>(G::HEIGHT),
+                                        static_cast<int64_t>(G::WIDTH)},
+                                       torch::TensorOptions().dtype(torch::kFloat).device(torch::kCPU));
+    game.encode(state.data_ptr<float>());
+    return state;
+}
+
+// The input planes of count positions as one (N, C, H, W) CPU tensor, encoded into its storage.
+template<Game G>
+torch::Tensor torchEncodedBatch(const G *games, size_t count) {
+    torch::Tensor batch = torch::empty(encodedShape<G>(count),
+                                       torch::TensorOptions().dtype(torch::kFloat).device(torch::kCPU));
+    encodeBatch(games, count, batch.data_ptr<float>());
+    return batch;
+}
+
+// Torch keeps 1D biases/statistics and 2D linear weights; nnm stores everything as 4D.
+inline nnm::Tensor4D toTensor4D(const torch::Tensor &tensor) {
+    torch::Tensor t = tensor.detach().to(torch::kCPU, torch::kFloat).contiguous();
+    std::vector<float> data(t.data_ptr<float>(), t.data_ptr<float>() + t.numel());
+    auto size = [&](int64_t d) { return static_cast<int>(t.size(d)); };
+    switch (t.dim()) {
+        case 1:
+            return {1, size(0), 1, 1, data};
+        case 2:
+            return {1, size(0), size(1), 1, data};
+        case 4:
+            return {size(0), size(1), size(2), size(3), data};
+        default:
+            throw std::invalid_argument("Cannot export a tensor with " + std::to_string(t.dim()) + " dims");
+    }
+}
+
+// Parameters and buffers by state_dict key, detached from the model.
+inline std::map<std::string, torch::Tensor> stateDict(TicTacToeModel &model) {
+    std::map<std::string, torch::Tensor> state;
+    for (const auto &parameter: model->named_parameters()) {
+        state[parameter.key()] = parameter.value().detach().clone();
+    }
+    for (const auto &buffer: model->named_buffers()) {
+        state[buffer.key()] = buffer.value().detach().clone();
+    }
+    return state;
+}
+
+// Copies the current torch weights into an nnm model of the same architecture, so searches can
+// run natively while training stays in libtorch. Weights keep the nnm model's dtype.
+inline void copyWeights(TicTacToeModel &source, nnm::TicTacToeModel &target) {
+    torch::NoGradGuard no_grad;
+    std::map<std::string, torch::Tensor> state = stateDict(source);
+    target.visit_parameters("", [&](const std::string &name, nnm::PackedTensor &tensor) {
+        auto it = state.find(name);
+        if (it == state.end()) {
+            throw std::invalid_argument("Torch model has no parameter named " + name);
+        }
+        nnm::Tensor4D value = toTensor4D(it->second);
+        if (value.shape() != tensor.shape()) {
+            throw std::invalid_argument("Torch and nnm shapes differ for " + name);
+        }
+        tensor = nnm::PackedTensor(value, tensor.dtype());
+    });
+}
+
+// Runs the libtorch model on the given device. Model is a module holder whose forward takes a batch
+// of encoded positions and returns softmaxed policies over G's actions and values. The model is put
+// in eval mode once here rather than on every call, so concurrent calls only read the module; it
+// must stay in eval mode while the evaluator is in use.
+template<Game G = TicTacToe, typename Model = TicTacToeModel>
+class TorchEvaluator final : public Evaluator<G> {
+private:
+    Model model;
+    torch::Device device;
+
+public:
+    TorchEvaluator(Model model, torch::Device device) : model(std::move(model)), device(device) {
+        this->model->to(device);
+        this->model->eval();
+    }
+
+    Evaluation evaluate(const G &game) override {
+        torch::NoGradGuard no_grad;
+        torch::Tensor policy, value;
+        std::tie(policy, value) = model->forward(torchEncodedState(game).to(device).unsqueeze(0));
+        policy = policy.to(torch::kCPU).contiguous();
+        const float *data = policy.data_ptr<float>();
+        return {std::vector<float>(data, data + policy.numel()), value.item<float>()};
+    }
+
+    // One forward and one device round trip for the whole batch.
+    std::vector<Evaluation> evaluateBatch(const std::vector<G> &games) override {
+        if (games.empty()) {
+            return {};
+        }
+        torch::NoGradGuard no_grad;
+        torch::Tensor batch = torchEncodedBatch(games.data(), games.size());
+        torch::Tensor policy, value;
+        std::tie(policy, value) = model->forward(batch.to(device));
+        policy = policy.to(torch::kCPU).contiguous();
+        value = value.to(torch::kCPU).contiguous();
+
+        const int64_t actions = policy.size(1);
+        const float *policy_data = policy.data_ptr<float>();
+        const float *value_data = value.data_ptr<float>();
+        std::vector<Evaluation> evaluations(games.size());
+        for (size_t i = 0; i < games.size(); ++i) {
+            const float *row = policy_data + static_cast<int64_t>(i) * actions;
+            evaluations[i] = {std::vector<float>(row, row + actions), value_data[i]};
+        }
+        return evaluations;
+    }
+};
@@ -5,6 +5,8 @@
 #include "TicTacToeModel.h"
 #include "MCTSLearn.h"
 #include "AlphaZero.h"
+#include "PrecomputedEvaluator.h"
+#include "TorchEvaluator.h"
 
 
 int main() {
@@ -12,8 +14,7 @@ int main() {
     std::cout << "Using device: " << (torch::cuda::is_available() ? "CUDA" : "CPU") << std::endl;
 
     TicTacToe game;
-    TicTacToeModel model;
-    model->to(device);
+    TicTacToeModel model(device.str());
 
     torch::optim::Adam optimizer(model->parameters(), torch::optim::AdamOptions(0.001));
 
@@ -23,11 +24,22 @@ int main() {
             {"num_epochs",              25},
             {"batch_size",              64},
             {"num_searches",            150},
+            {"search_batch_size",       16},
+            {"adaptive_search_batch",   1},
             {"dirichlet_epsilon",       0.25},
             {"dirichlet_alpha",         0.3},
             {"temperature",             1.25},
             {"thread_factor",           0.75},
-            {"eval_games",              100}
+            // Self-play games in flight at once; their search leaves are evaluated together in one batch.
+            {"concurrent_games",        256},
+            {"eval_games",              100},
+            // Promotion compares both models with the exact solution instead of playing eval_games.
+            {"solver_gate",             1},
+            // A table of all 5478 positions, refilled after every training step, replaces the network.
+            {"precomputed_search",      1},
+            {"search_threads",          static_cast<float>(std::max(1u, std::thread::hardware_concurrency()))},
+            // Without a GPU, searching on the native runtime is much faster than libtorch on the CPU.
+            {"native_search",           torch::cuda::is_available() ? 0.0f : 1.0f}
     };
 
     AlphaZero alphaZero(model, optimizer, game, args);
@@ -47,11 +59,13 @@ int maina() {
     torch::Device device(torch::cuda::is_available() ? torch::kCUDA : torch::kCPU);
     std::cout << "Using device: " << (torch::cuda::is_available() ? "CUDA" : "CPU") << std::endl;
 
-    TicTacToeModel model;
-    model->to(device);
+    TicTacToeModel model(device.str());
 
     torch::load(model, "best_model.pt");
     model->eval();
+    TorchEvaluator model_evaluator(model, device);
+    // The weights never change here, so every position is evaluated once before the game starts.
+    PrecomputedEvaluator evaluator(model_evaluator);
 
     TicTacToe game;
     std::map<std::string, float> args = {
@@ -63,7 +77,10 @@ int maina() {
             {"eval_games",        100},
             {"log_interval",      15}
     };
-    MCTSLearn mcts(args["dirichlet_epsilon"], args["dirichlet_alpha"]);
+    MCTSLearn<TicTacToe> mcts(args["dirichlet_epsilon"], args["dirichlet_alpha"]);
+
+    // Kept across moves, so the AI starts each search from what it already explored.
+    SearchTree tree(game);
 
     std::cout << "Welcome to Tic-Tac-Toe!" << std::endl;
 
@@ -97,8 +114,10 @@ int maina() {
                 std::cout << "Invalid move. Try again." << std::endl;
             }
             game.makeMove(move);
+            tree.advance(move);
         } else {
-            std::vector<float> action_probs = mcts.search(game, model, args["num_searches"]);
+            std::vector<float> action_probs = mcts.searchParallel(tree, evaluator, args["num_searches"],
+                                                                   std::max(1u, std::thread::hardware_concurrency()));
             std::cout << "Action probabilities:" << std::endl;
             for (int i = 0; i < 9; ++i) {
                 std::cout << i << ": " << action_probs[i] << " ";
@@ -109,11 +128,14 @@ int maina() {
             std::mt19937 gen(std::random_device{}());
             int ai_move = dist(gen);
 
-            auto [policy, value] = model(game.getTorchEncodedState().to(torch::kCUDA).unsqueeze(0));
             std::cout << "AI policy:" << std::endl;
-            std::cout << policy << std::endl;
+            for (float p: evaluator.evaluate(game).policy) {
+                std::cout << p << " ";
+            }
+            std::cout << std::endl;
 
             game.makeMove(ai_move);
+            tree.advance(ai_move);
             std::cout << "AI chose move: " << ai_move << std::endl;
         }
 
@@ -2,6 +2,7 @@
 
 #include "Layer.h"
 #include "Tensor4D.h"
+#include "PackedTensor.h"
 #include <vector>
 #include <cmath>
 #include <memory>
@@ -16,10 +17,23 @@ namespace nnm {
         double eps;
         std::optional<float> momentum;
 
-        std::vector<float> weight;
-        std::vector<float> bias;
-        std::vector<float> running_mean;
-        std::vector<float> running_var;
+        // (1, C, 1, 1) float tensors; empty when the layer was built without affine or running stats.
+        PackedTensor weight;
+        PackedTensor bias;
+        PackedTensor running_mean;
+        PackedTensor running_var;
+
+        static PackedTensor filled(size_t channels, float value) {
+            return {Tensor4D(1, channels, 1, 1, value), DType::F32};
+        }
+
+        static PackedTensor perChannel(const Tensor4D &values, size_t channels) {
+            Tensor4D result(1, channels, 1, 1);
+            for (size_t c = 0; c < channels; ++c) {
+                result(0, c, 0, 0) = values(0, c, 0, 0);
+            }
+            return {result, DType::F32};
+        }
 
     public:
         BatchNorm2d(size_t num_features, double eps = 1e-5, std::optional<double> momentum = 0.1,
@@ -27,51 +41,70 @@ namespace nnm {
                 : num_features(num_features), eps(eps), momentum(momentum) {
 
             if (affine) {
-                weight.resize(num_features, 1.0f);
-                bias.resize(num_features, 0.0f);
+                weight = filled(num_features, 1.0f);
+                bias = filled(num_features, 0.0f);
             }
 
             if (track_running_stats) {
-                running_mean.resize(num_features, 0.0f);
-                running_var.resize(num_features, 1.0f);
+                running_mean = filled(num_features, 0.0f);
+                running_var = filled(num_features, 1.0f);
             }
         }
 
         Tensor4D forward(const Tensor4D &input) override {
+            return forward(Tensor4D(input));
+        }
+
+        Tensor4D forward(Tensor4D &&input) override {
             if (input.getChannels() != num_features) {
                 throw std::invalid_argument("Input channel dimension doesn't match num_features");
             }
 
-            Tensor4D output(input.getBatchSize(), num_features, input.getHeight(), input.getWidth());
+            // Fold the running statistics into one scale and shift per channel, then apply
+            // x * scale + shift broadcast over (N, H, W).
+            Tensor4D scale(1, num_features, 1, 1);
+            Tensor4D shift(1, num_features, 1, 1);
+            const float *gammas = weight.empty() ? nullptr : weight.data_as<DType::F32>();
+            const float *betas = bias.empty() ? nullptr : bias.data_as<DType::F32>();
+            const float *means = running_mean.empty() ? nullptr : running_mean.data_as<DType::F32>();
+            const float *vars = running_var.empty() ? nullptr : running_var.data_as<DType::F32>();
+            bool identity = true;
+            for (size_t c = 0; c < num_features; c++) {
+                double var = vars ? static_cast<double>(vars[c]) : 1.0;
+                double mean = means ? static_cast<double>(means[c]) : 0.0;
+                double inv_std = 1.0 / std::sqrt(var + eps);
+                double gamma = gammas ? static_cast<double>(gammas[c]) : 1.0;
+                double beta = betas ? static_cast<double>(betas[c]) : 0.0;
+                scale(0, c, 0, 0) = static_cast<float>(inv_std * gamma);
+                shift(0, c, 0, 0) = static_cast<float>(beta - mean * inv_std * gamma);
+                identity = identity && scale(0, c, 0, 0) == 1.0f && shift(0, c, 0, 0) == 0.0f;
+            }
+            // Batch norm folded into the previous convolution at export time leaves nothing to apply.
+            if (identity) {
+                return std::move(input);
+            }
 
-            int64_t n_batch = input.getBatchSize();
-            int64_t n_channel = num_features;
+            float *x = input.getData().data();
+            elementwise::ternary(x, input.shape(), x, input.shape(),
+                                 scale.getData().data(), scale.shape(),
+                                 shift.getData().data(), shift.shape(), elementwise::MulAdd{});
 
-            std::vector<double> inv_std(n_channel);
-            std::vector<double> gamma(n_channel);
-            std::vector<double> beta(n_channel);
+            return std::move(input);
+        }
 
-            for (int64_t c = 0; c < n_channel; c++) {
-                inv_std[c] = 1.0 / std::sqrt(static_cast<double>(running_var[c]) + static_cast<double>(eps));
-                gamma[c] = weight.empty() ? 1.0 : static_cast<double>(weight[c]);
-                beta[c] = bias.empty() ? 0.0 : static_cast<double>(bias[c]);
-            }
+        // Normalization parameters stay in float; they are a few values per channel.
+        size_t weight_bytes() const override {
+            return weight.nbytes() + bias.nbytes() + running_mean.nbytes() + running_var.nbytes();
+        }
 
-            for (int64_t n = 0; n < n_batch; ++n) {
-                for (int64_t c = 0; c < n_channel; ++c) {
-                    double inv_std_gamma = inv_std[c] * gamma[c];
-
-                    for (int64_t h = 0; h < input.getHeight(); ++h) {
-                        for (int64_t w = 0; w < input.getWidth(); ++w) {
-                            double x = static_cast<double>(input(n, c, h, w));
-                            double normalized = (x - running_mean[c]) * inv_std_gamma + beta[c];
-                            output(n, c, h, w) = static_cast<float>(normalized);
-                        }
-                    }
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            for (auto [name, tensor]: {std::pair{"weight", &weight}, {"bias", &bias},
+                                       {"running_mean", &running_mean}, {"running_var", &running_var}}) {
+                if (!tensor->empty()) {
+                    visit(prefix + name, *tensor);
+                    *tensor = tensor->converted(DType::F32);
                 }
             }
-
-            return output;
         }
 
         std::string get_name() const override {
@@ -94,12 +127,10 @@ namespace nnm {
                 throw std::invalid_argument("Parameter sizes do not match num_features");
             }
 
-            for (size_t c = 0; c < num_features; ++c) {
-                this->weight[c] = weight(0, c, 0, 0);
-                this->bias[c] = bias(0, c, 0, 0);
-                this->running_mean[c] = running_mean(0, c, 0, 0);
-                this->running_var[c] = running_var(0, c, 0, 0);
-            }
+            this->weight = perChannel(weight, num_features);
+            this->bias = perChannel(bias, num_features);
+            this->running_mean = perChannel(running_mean, num_features);
+            this->running_var = perChannel(running_var, num_features);
 
 
             this->momentum = momentum;
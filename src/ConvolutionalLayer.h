@@ -2,16 +2,20 @@
 
 #include "Layer.h"
 #include "Tensor4D.h"
-#include "Matrix.h"
+#include "PackedTensor.h"
+#include "Gemm.h"
+#include "Quantization.h"
 #include <random>
+#include <vector>
 
 namespace nnm {
 
     class ConvolutionalLayer : public Layer<Tensor4D, Tensor4D> {
     private:
         size_t in_channels, out_channels, kernel_size, stride, padding;
-        Tensor4D weights;
-        Tensor4D bias;
+        PackedTensor weights;
+        PackedTensor bias;
+        quant::LayerQuantizer int8;
         Tensor4D weight_gradients;
         Tensor4D bias_gradients;
 
@@ -20,8 +24,6 @@ namespace nnm {
                            size_t stride = 1, size_t padding = 0)
                 : in_channels(in_channels), out_channels(out_channels), kernel_size(kernel_size),
                   stride(stride), padding(padding),
-                  weights(out_channels, in_channels, kernel_size, kernel_size),
-                  bias(1, out_channels, 1, 1),
                   weight_gradients(out_channels, in_channels, kernel_size, kernel_size),
                   bias_gradients(1, out_channels, 1, 1) {
 
@@ -32,18 +34,20 @@ namespace nnm {
                     6.0f / (in_channels * kernel_size * kernel_size + out_channels * kernel_size * kernel_size));
             std::uniform_real_distribution<> dis(-limit, limit);
 
+            Tensor4D initial(out_channels, in_channels, kernel_size, kernel_size);
             for (size_t o = 0; o < out_channels; ++o) {
                 for (size_t i = 0; i < in_channels; ++i) {
                     for (size_t h = 0; h < kernel_size; ++h) {
                         for (size_t w = 0; w < kernel_size; ++w) {
-                            weights(o, i, h, w) = static_cast<float>(dis(gen));
+                            initial(o, i, h, w) = static_cast<float>(dis(gen));
                         }
                     }
                 }
             }
+            weights = PackedTensor(initial, DType::F32);
 
             // Initialize biases to zero
-            bias.fill(0.0f);
+            bias = PackedTensor(Tensor4D(1, out_channels, 1, 1), DType::F32);
 
             // Initialize gradients to zero
             weight_gradients.fill(0.0f);
@@ -51,42 +55,63 @@ namespace nnm {
         }
 
         Tensor4D forward(const Tensor4D &input) override {
+            if (input.getChannels() != in_channels) {
+                throw std::invalid_argument("Input channels do not match layer's in_channels");
+            }
             size_t N = input.getBatchSize();
             size_t H = input.getHeight();
             size_t W = input.getWidth();
 
             size_t H_out = 1 + (H + 2 * padding - kernel_size) / stride;
             size_t W_out = 1 + (W + 2 * padding - kernel_size) / stride;
+            size_t positions = H_out * W_out;
+            size_t patch = in_channels * kernel_size * kernel_size;
 
             Tensor4D output(N, out_channels, H_out, W_out);
+            std::vector<float> columns(positions * patch);
 
-            Tensor4D padded_input = input.pad({{0,       0},
-                                               {0,       0},
-                                               {padding, padding},
-                                               {padding, padding}});
-
+            // One patch per output position, laid out like a weight row, so each output channel is a
+            // dot product of two contiguous rows. The product is written straight into NCHW order.
+            const float *bias_data = bias.data_as<DType::F32>();
+            int8.observe(input);
             for (size_t n = 0; n < N; ++n) {
-                for (size_t f = 0; f < out_channels; ++f) {
-                    int height_index = 0;
-                    for (size_t i = 0; i < H; i += stride) {
-                        int width_index = 0;
-                        for (size_t j = 0; j < W; j += stride) {
-                            Tensor4D x_slice = padded_input.subTensor(n, 0, i, j,
-                                                                      1, in_channels, kernel_size, kernel_size);
-                            Tensor4D w_slice = weights.subTensor(f, 0, 0, 0,
-                                                                 1, in_channels, kernel_size, kernel_size);
-                            float sum = x_slice.elementWiseMul(w_slice).sum() + bias(0, f, 0, 0);
-                            output(n, f, height_index, width_index) = sum;
-                            width_index++;
-                        }
-                        height_index++;
-                    }
+                im2col(input, n, H_out, W_out, columns.data());
+                float *out = output.getData().data() + n * out_channels * positions;
+                if (int8.active()) {
+                    int8.gemm(columns.data(), positions, patch, bias_data, out, 1, positions);
+                } else {
+                    gemm::gemm_nt(columns.data(), positions, patch, weights, out_channels, bias_data, out, 1,
+                                  positions);
                 }
             }
 
             return output;
         }
 
+        void convert_weights(DType dtype) override {
+            weights = weights.converted(dtype);
+        }
+
+        void calibrate(bool enabled) override {
+            int8.calibrate(enabled);
+        }
+
+        void use_int8(bool enabled) override {
+            int8.enable(enabled, weights, out_channels, in_channels * kernel_size * kernel_size);
+        }
+
+        [[nodiscard]] size_t weight_bytes() const override {
+            return weights.nbytes() + bias.nbytes();
+        }
+
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            visit(prefix + "weight", weights);
+            visit(prefix + "bias", bias);
+            // Biases feed the kernels directly and are kept in float whatever the source stored.
+            bias = bias.converted(DType::F32);
+            int8.refresh(weights, out_channels, in_channels * kernel_size * kernel_size);
+        }
+
         [[nodiscard]] std::string get_name() const override {
             return "ConvolutionalLayer";
         }
@@ -99,17 +124,28 @@ namespace nnm {
             return out_channels;
         }
 
+        // New weights keep the layer's current storage precision.
         void set_weights(const Tensor4D &new_weights) {
-            weights = new_weights;
+            if (new_weights.getBatchSize() != out_channels || new_weights.getChannels() != in_channels ||
+                new_weights.getHeight() != kernel_size || new_weights.getWidth() != kernel_size) {
+                throw std::invalid_argument("New weights dimensions do not match layer dimensions");
+            }
+            weights = PackedTensor(new_weights, weights.dtype());
+            int8.refresh(weights, out_channels, in_channels * kernel_size * kernel_size);
         }
 
         void set_bias(const Tensor4D &new_bias) {
-            bias = new_bias;
+            if (new_bias.getData().size() != out_channels) {
+                throw std::invalid_argument("New bias dimensions do not match layer dimensions");
+            }
+            bias = PackedTensor(Tensor4D(1, static_cast<int>(out_channels), 1, 1, new_bias.getData()), DType::F32);
         }
 
-        [[nodiscard]] const Tensor4D &get_weights() const { return weights; }
+        [[nodiscard]] Tensor4D get_weights() const { return weights.toTensor(); }
+
+        [[nodiscard]] const PackedTensor &get_packed_weights() const { return weights; }
 
-        [[nodiscard]] const Tensor4D &get_bias() const { return bias; }
+        [[nodiscard]] Tensor4D get_bias() const { return bias.toTensor(); }
 
         [[nodiscard]] size_t get_padding() const { return padding; }
 
@@ -124,6 +160,33 @@ namespace nnm {
         Tensor4D get_bias_gradients() {
             return bias_gradients;
         }
+
+    private:
+        void im2col(const Tensor4D &input, size_t n, size_t H_out, size_t W_out, float *columns) const {
+            const size_t H = input.getHeight();
+            const size_t W = input.getWidth();
+            const size_t patch = in_channels * kernel_size * kernel_size;
+            const float *image = input.getData().data() + n * in_channels * H * W;
+
+            for (size_t oh = 0; oh < H_out; ++oh) {
+                for (size_t ow = 0; ow < W_out; ++ow) {
+                    float *row = columns + (oh * W_out + ow) * patch;
+                    for (size_t c = 0; c < in_channels; ++c) {
+                        for (size_t kh = 0; kh < kernel_size; ++kh) {
+                            // Signed so the padding border can be tested without wrapping.
+                            ptrdiff_t h = static_cast<ptrdiff_t>(oh * stride + kh) - static_cast<ptrdiff_t>(padding);
+                            for (size_t kw = 0; kw < kernel_size; ++kw) {
+                                ptrdiff_t w = static_cast<ptrdiff_t>(ow * stride + kw) -
+                                              static_cast<ptrdiff_t>(padding);
+                                bool inside = h >= 0 && h < static_cast<ptrdiff_t>(H) &&
+                                              w >= 0 && w < static_cast<ptrdiff_t>(W);
+                                *row++ = inside ? image[(c * H + h) * W + w] : 0.0f;
+                            }
+                        }
+                    }
+                }
+            }
+        }
     };
 
 } // namespace nnm
\ No newline at end of file
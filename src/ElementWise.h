@@ -0,0 +1,351 @@
+#pragma once
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <immintrin.h>
+
+namespace nnm::elementwise {
+
+    // Below this many output elements the work stays on the calling thread.
+    constexpr size_t PARALLEL_THRESHOLD = 1 << 15;
+    // Granularity of the parallel split for contiguous kernels.
+    constexpr size_t PARALLEL_BLOCK = 1 << 12;
+
+    using Shape4 = std::array<size_t, 4>;
+
+    inline size_t numel(const Shape4 &shape) {
+        return shape[0] * shape[1] * shape[2] * shape[3];
+    }
+
+    // Ops provide a scalar operator() for tails and, when possible, an AVX2 overload on __m256.
+    // Ops without the vector overload still run through the engine, one lane at a time.
+
+    struct Copy {
+        float operator()(float a) const { return a; }
+
+        __m256 operator()(__m256 a) const { return a; }
+    };
+
+    struct Relu {
+        float operator()(float a) const { return std::max(0.0f, a); }
+
+        __m256 operator()(__m256 a) const { return _mm256_max_ps(a, _mm256_setzero_ps()); }
+    };
+
+    struct Scale {
+        float s;
+
+        float operator()(float a) const { return a * s; }
+
+        __m256 operator()(__m256 a) const { return _mm256_mul_ps(a, _mm256_set1_ps(s)); }
+    };
+
+    struct AddScalar {
+        float s;
+
+        float operator()(float a) const { return a + s; }
+
+        __m256 operator()(__m256 a) const { return _mm256_add_ps(a, _mm256_set1_ps(s)); }
+    };
+
+    struct Clamp {
+        float lo, hi;
+
+        float operator()(float a) const { return std::min(std::max(a, lo), hi); }
+
+        __m256 operator()(__m256 a) const {
+            return _mm256_min_ps(_mm256_max_ps(a, _mm256_set1_ps(lo)), _mm256_set1_ps(hi));
+        }
+    };
+
+    struct Tanh {
+        float operator()(float a) const { return std::tanh(a); }
+    };
+
+    // Cephes-style exp: range reduction to [-ln2/2, ln2/2] and a degree-5 polynomial.
+    // Relative error stays within a few ulp over the clamped input range.
+    inline __m256 exp256(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3365447505f)), _mm256_set1_ps(88.0f));
+
+        __m256 fx = _mm256_floor_ps(_mm256_fmadd_ps(x, _mm256_set1_ps(1.44269504088896341f), _mm256_set1_ps(0.5f)));
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(0.693359375f), x);
+        x = _mm256_fnmadd_ps(fx, _mm256_set1_ps(-2.12194440e-4f), x);
+
+        __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+        y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+        y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), _mm256_add_ps(x, _mm256_set1_ps(1.0f)));
+
+        __m256i n = _mm256_add_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32(127));
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(_mm256_slli_epi32(n, 23)));
+    }
+
+    struct Exp {
+        float operator()(float a) const { return std::exp(a); }
+
+        __m256 operator()(__m256 a) const { return exp256(a); }
+    };
+
+    struct Add {
+        float operator()(float a, float b) const { return a + b; }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_add_ps(a, b); }
+    };
+
+    struct Sub {
+        float operator()(float a, float b) const { return a - b; }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_sub_ps(a, b); }
+    };
+
+    struct Mul {
+        float operator()(float a, float b) const { return a * b; }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_mul_ps(a, b); }
+    };
+
+    struct Div {
+        float operator()(float a, float b) const { return a / b; }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_div_ps(a, b); }
+    };
+
+    struct Max {
+        float operator()(float a, float b) const { return std::max(a, b); }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_max_ps(a, b); }
+    };
+
+    struct Min {
+        float operator()(float a, float b) const { return std::min(a, b); }
+
+        __m256 operator()(__m256 a, __m256 b) const { return _mm256_min_ps(a, b); }
+    };
+
+    // a * b + c
+    struct MulAdd {
+        float operator()(float a, float b, float c) const { return std::fma(a, b, c); }
+
+        __m256 operator()(__m256 a, __m256 b, __m256 c) const { return _mm256_fmadd_ps(a, b, c); }
+    };
+
+    namespace detail {
+
+        // True when Op has an AVX2 overload taking K __m256 arguments.
+        template<typename Op, size_t K>
+        constexpr bool hasVectorKernel() {
+            if constexpr (K == 1) {
+                return requires(const Op &op, __m256 v) { _mm256_storeu_ps(nullptr, op(v)); };
+            } else if constexpr (K == 2) {
+                return requires(const Op &op, __m256 v) { _mm256_storeu_ps(nullptr, op(v, v)); };
+            } else {
+                return requires(const Op &op, __m256 v) { _mm256_storeu_ps(nullptr, op(v, v, v)); };
+            }
+        }
+
+        // One operand of an inner run: either a contiguous pointer or a value repeated across the run.
+        struct Operand {
+            const float *ptr;
+            bool contiguous;
+
+            float scalar(size_t i) const { return contiguous ? ptr[i] : ptr[0]; }
+
+            __m256 vector(size_t i) const { return contiguous ? _mm256_loadu_ps(ptr + i) : _mm256_set1_ps(ptr[0]); }
+        };
+
+        template<typename Op, size_t K, size_t... I>
+        void runInner(float *out, size_t n, const Op &op, const std::array<Operand, K> &in,
+                      std::index_sequence<I...>) {
+            size_t i = 0;
+            if constexpr (hasVectorKernel<Op, K>()) {
+                for (; i + 32 <= n; i += 32) {
+                    __m256 r0 = op(in[I].vector(i)...);
+                    __m256 r1 = op(in[I].vector(i + 8)...);
+                    __m256 r2 = op(in[I].vector(i + 16)...);
+                    __m256 r3 = op(in[I].vector(i + 24)...);
+                    _mm256_storeu_ps(out + i, r0);
+                    _mm256_storeu_ps(out + i + 8, r1);
+                    _mm256_storeu_ps(out + i + 16, r2);
+                    _mm256_storeu_ps(out + i + 24, r3);
+                }
+                for (; i + 8 <= n; i += 8) {
+                    _mm256_storeu_ps(out + i, op(in[I].vector(i)...));
+                }
+            }
+            // Counted from what is left, so the trip count stays provable after the vector loops.
+            const size_t remaining = n - i;
+            for (size_t k = 0; k < remaining; ++k) {
+                out[i + k] = op(in[I].scalar(i + k)...);
+            }
+        }
+
+        template<typename Op, size_t K>
+        void runContiguous(float *out, size_t n, const Op &op, const std::array<Operand, K> &in) {
+            auto run = [&](size_t begin, size_t end) {
+                std::array<Operand, K> operands = in;
+                for (size_t k = 0; k < K; ++k) {
+                    if (operands[k].contiguous) {
+                        operands[k].ptr += begin;
+                    }
+                }
+                runInner(out + begin, end - begin, op, operands, std::make_index_sequence<K>{});
+            };
+
+            if (n < PARALLEL_THRESHOLD) {
+                run(0, n);
+                return;
+            }
+            const ptrdiff_t blocks = static_cast<ptrdiff_t>((n + PARALLEL_BLOCK - 1) / PARALLEL_BLOCK);
+#pragma omp parallel for schedule(static)
+            for (ptrdiff_t b = 0; b < blocks; ++b) {
+                size_t begin = static_cast<size_t>(b) * PARALLEL_BLOCK;
+                run(begin, std::min(n, begin + PARALLEL_BLOCK));
+            }
+        }
+
+        template<typename Op, size_t K>
+        void runBroadcast(float *out, const Shape4 &out_shape, const Op &op,
+                          const std::array<const float *, K> &in, const std::array<Shape4, K> &shapes) {
+            // Element strides of every operand; broadcast dimensions get a zero stride.
+            std::array<std::array<size_t, 4>, K> strides{};
+            bool all_equal = true;
+            for (size_t k = 0; k < K; ++k) {
+                size_t stride = 1;
+                for (int d = 3; d >= 0; --d) {
+                    if (shapes[k][d] == out_shape[d]) {
+                        strides[k][d] = out_shape[d] == 1 ? 0 : stride;
+                    } else if (shapes[k][d] == 1) {
+                        strides[k][d] = 0;
+                        all_equal = false;
+                    } else {
+                        throw std::invalid_argument("Tensor shapes cannot be broadcast together");
+                    }
+                    stride *= shapes[k][d];
+                }
+            }
+            if (all_equal) {
+                std::array<Operand, K> operands;
+                for (size_t k = 0; k < K; ++k) {
+                    operands[k] = {in[k], true};
+                }
+                runContiguous(out, numel(out_shape), op, operands);
+                return;
+            }
+
+            // Coalesce adjacent dimensions that every operand walks the same way, so that the
+            // innermost run is as long as possible, e.g. a (1, C, 1, 1) bias over (N, C, H, W)
+            // becomes an (N, C) loop over runs of H * W with a repeated bias value.
+            std::array<size_t, 4> dims{};
+            std::array<std::array<size_t, 4>, K> dim_strides{};
+            int rank = 0;
+            for (int d = 3; d >= 0; --d) {
+                if (out_shape[d] == 1) {
+                    continue;
+                }
+                bool merge = rank > 0;
+                for (size_t k = 0; k < K && merge; ++k) {
+                    merge = strides[k][d] == dim_strides[k][rank - 1] * dims[rank - 1];
+                }
+                if (merge) {
+                    dims[rank - 1] *= out_shape[d];
+                } else {
+                    dims[rank] = out_shape[d];
+                    for (size_t k = 0; k < K; ++k) {
+                        dim_strides[k][rank] = strides[k][d];
+                    }
+                    ++rank;
+                }
+            }
+            if (rank == 0) {
+                dims[0] = 1;
+                rank = 1;
+            }
+
+            const size_t inner = dims[0];
+            size_t outer = 1;
+            for (int r = 1; r < rank; ++r) {
+                outer *= dims[r];
+            }
+
+            auto run_row = [&](size_t row) {
+                std::array<Operand, K> operands;
+                size_t rest = row;
+                std::array<size_t, K> offsets{};
+                for (int r = 1; r < rank; ++r) {
+                    size_t idx = rest % dims[r];
+                    rest /= dims[r];
+                    for (size_t k = 0; k < K; ++k) {
+                        offsets[k] += idx * dim_strides[k][r];
+                    }
+                }
+                for (size_t k = 0; k < K; ++k) {
+                    operands[k] = {in[k] + offsets[k], dim_strides[k][0] != 0};
+                }
+                runInner(out + row * inner, inner, op, operands, std::make_index_sequence<K>{});
+            };
+
+            const auto rows = static_cast<ptrdiff_t>(outer);
+#pragma omp parallel for schedule(static) if (outer > 1 && outer * inner >= PARALLEL_THRESHOLD)
+            for (ptrdiff_t row = 0; row < rows; ++row) {
+                run_row(static_cast<size_t>(row));
+            }
+        }
+
+    } // namespace detail
+
+    // NumPy-style result shape: each dimension must match or be 1 on one side.
+    inline Shape4 broadcastShape(const Shape4 &a, const Shape4 &b) {
+        Shape4 result{};
+        for (size_t d = 0; d < 4; ++d) {
+            if (a[d] != b[d] && a[d] != 1 && b[d] != 1) {
+                throw std::invalid_argument("Tensor shapes cannot be broadcast together");
+            }
+            result[d] = a[d] == 1 ? b[d] : a[d];
+        }
+        return result;
+    }
+
+    template<typename Op>
+    void unary(float *out, const float *a, size_t n, Op op) {
+        detail::runContiguous<Op, 1>(out, n, op, {{{a, true}}});
+    }
+
+    template<typename Op>
+    void binary(float *out, const float *a, const float *b, size_t n, Op op) {
+        detail::runContiguous<Op, 2>(out, n, op, {{{a, true}, {b, true}}});
+    }
+
+    template<typename Op>
+    void ternary(float *out, const float *a, const float *b, const float *c, size_t n, Op op) {
+        detail::runContiguous<Op, 3>(out, n, op, {{{a, true}, {b, true}, {c, true}}});
+    }
+
+    template<typename Op>
+    void binary(float *out, const Shape4 &out_shape,
+                const float *a, const Shape4 &a_shape,
+                const float *b, const Shape4 &b_shape, Op op) {
+        detail::runBroadcast<Op, 2>(out, out_shape, op, {a, b}, {a_shape, b_shape});
+    }
+
+    template<typename Op>
+    void ternary(float *out, const Shape4 &out_shape,
+                 const float *a, const Shape4 &a_shape,
+                 const float *b, const Shape4 &b_shape,
+                 const float *c, const Shape4 &c_shape, Op op) {
+        detail::runBroadcast<Op, 3>(out, out_shape, op, {a, b, c}, {a_shape, b_shape, c_shape});
+    }
+
+    inline void fill(float *out, size_t n, float value) {
+        detail::runContiguous<Copy, 1>(out, n, Copy{}, {{{&value, false}}});
+    }
+
+} // namespace nnm::elementwise
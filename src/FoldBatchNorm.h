@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cmath>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include "Tensor4D.h"
+
+namespace nnm {
+
+    // Folds an inference-mode batch norm into the convolution before it, on a state dict in the nnm
+    // 4D layout. conv and bn are state-dict prefixes ("conv1", "bn1"). Every output channel of the
+    // convolution is scaled by gamma / sqrt(var + eps) and its bias becomes
+    // (bias - mean) * scale + beta. The batch norm is then written as an exact identity, which
+    // BatchNorm2d recognizes and skips.
+    inline void fold_batch_norm(std::map<std::string, Tensor4D> &state, const std::string &conv,
+                                const std::string &bn, double eps = 1e-5) {
+        auto find = [&](const std::string &name) -> Tensor4D & {
+            auto it = state.find(name);
+            if (it == state.end()) {
+                throw std::invalid_argument("Cannot fold batch norm: state has no tensor named " + name);
+            }
+            return it->second;
+        };
+        const Tensor4D gamma = find(bn + ".weight");
+        const Tensor4D beta = find(bn + ".bias");
+        const Tensor4D mean = find(bn + ".running_mean");
+        const Tensor4D var = find(bn + ".running_var");
+        Tensor4D &weight = find(conv + ".weight");
+
+        const size_t channels = weight.getBatchSize();
+        if (gamma.getChannels() != channels || beta.getChannels() != channels ||
+            mean.getChannels() != channels || var.getChannels() != channels) {
+            throw std::invalid_argument("Cannot fold " + bn + " into " + conv + ": channel counts differ");
+        }
+        auto bias_it = state.find(conv + ".bias");
+        Tensor4D bias = bias_it != state.end() ? bias_it->second : Tensor4D(1, channels, 1, 1, 0.0f);
+
+        const size_t per_channel = weight.getChannels() * weight.getHeight() * weight.getWidth();
+        float *weights = weight.getData().data();
+        for (size_t c = 0; c < channels; ++c) {
+            const double scale = gamma(0, c, 0, 0) / std::sqrt(static_cast<double>(var(0, c, 0, 0)) + eps);
+            for (size_t i = 0; i < per_channel; ++i) {
+                weights[c * per_channel + i] = static_cast<float>(weights[c * per_channel + i] * scale);
+            }
+            bias(0, c, 0, 0) = static_cast<float>((bias(0, c, 0, 0) - mean(0, c, 0, 0)) * scale + beta(0, c, 0, 0));
+        }
+        state.insert_or_assign(conv + ".bias", bias);
+
+        state.insert_or_assign(bn + ".weight", Tensor4D(1, channels, 1, 1, 1.0f));
+        state.insert_or_assign(bn + ".bias", Tensor4D(1, channels, 1, 1, 0.0f));
+        state.insert_or_assign(bn + ".running_mean", Tensor4D(1, channels, 1, 1, 0.0f));
+        // BatchNorm2d computes 1 / sqrt(var + eps); this variance makes that exactly 1 in float.
+        state.insert_or_assign(bn + ".running_var", Tensor4D(1, channels, 1, 1, static_cast<float>(1.0 - eps)));
+    }
+
+} // namespace nnm
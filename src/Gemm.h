@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
+#include <immintrin.h>
+#include "Half.h"
+#include "PackedTensor.h"
+#include "Reduction.h"
+
+namespace nnm::gemm {
+
+    // Below this many multiply-adds the product stays on the calling thread.
+    constexpr size_t PARALLEL_WORK = 1 << 18;
+    // Register tile: MR rows of A against NR weight rows keeps MR * NR accumulators plus the loads in registers.
+    constexpr size_t MR = 2;
+    constexpr size_t NR = 4;
+
+    namespace detail {
+
+        template<DType D, size_t R, size_t S>
+        void tile(const float *A, size_t K, const half::storage_t<D> *W, const float *bias,
+                  float *C, size_t c_row, size_t c_col) {
+            __m256 acc[R][S];
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < S; ++j) {
+                    acc[i][j] = _mm256_setzero_ps();
+                }
+            }
+
+            size_t k = 0;
+            for (; k + 8 <= K; k += 8) {
+                __m256 w[S];
+                for (size_t j = 0; j < S; ++j) {
+                    w[j] = half::load8<D>(W + j * K + k);
+                }
+                for (size_t i = 0; i < R; ++i) {
+                    __m256 a = _mm256_loadu_ps(A + i * K + k);
+                    for (size_t j = 0; j < S; ++j) {
+                        acc[i][j] = _mm256_fmadd_ps(a, w[j], acc[i][j]);
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < S; ++j) {
+                    float total = reduction::detail::hsum(acc[i][j]);
+                    for (size_t t = k; t < K; ++t) {
+                        total += A[i * K + t] * half::load1<D>(W + j * K + t);
+                    }
+                    C[i * c_row + j * c_col] = total + (bias ? bias[j] : 0.0f);
+                }
+            }
+        }
+
+        template<DType D, size_t R, size_t S = NR>
+        void edgeTile(size_t cols, const float *A, size_t K, const half::storage_t<D> *W,
+                      const float *bias, float *C, size_t c_row, size_t c_col) {
+            if constexpr (S == 0) {
+                return;
+            } else if (cols == S) {
+                tile<D, R, S>(A, K, W, bias, C, c_row, c_col);
+            } else {
+                edgeTile<D, R, S - 1>(cols, A, K, W, bias, C, c_row, c_col);
+            }
+        }
+
+        template<DType D>
+        void gemm(const float *A, size_t M, size_t K, const half::storage_t<D> *W, size_t N,
+                  const float *bias, float *C, size_t c_row, size_t c_col) {
+            const size_t row_tiles = (M + MR - 1) / MR;
+            const size_t col_tiles = (N + NR - 1) / NR;
+            const ptrdiff_t tiles = static_cast<ptrdiff_t>(row_tiles * col_tiles);
+
+#pragma omp parallel for schedule(static) if (M * N * K >= PARALLEL_WORK)
+            for (ptrdiff_t t = 0; t < tiles; ++t) {
+                size_t m = (static_cast<size_t>(t) / col_tiles) * MR;
+                size_t n = (static_cast<size_t>(t) % col_tiles) * NR;
+                size_t rows = std::min(MR, M - m);
+                size_t cols = std::min(NR, N - n);
+                const float *a = A + m * K;
+                const half::storage_t<D> *w = W + n * K;
+                const float *b = bias ? bias + n : nullptr;
+                float *c = C + m * c_row + n * c_col;
+                if (rows == MR) {
+                    edgeTile<D, MR>(cols, a, K, w, b, c, c_row, c_col);
+                } else {
+                    edgeTile<D, 1>(cols, a, K, w, b, c, c_row, c_col);
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // C[m * c_row + n * c_col] = bias[n] + sum_k A[m, k] * W[n, k]
+    // A is row-major M x K in float; W is row-major N x K in any packed dtype and is widened to float
+    // in registers, so 16-bit weights halve the bytes streamed per product. bias may be null.
+    inline void gemm_nt(const float *A, size_t M, size_t K, const PackedTensor &W, size_t N,
+                        const float *bias, float *C, size_t c_row, size_t c_col) {
+        if (W.size() != N * K) {
+            throw std::invalid_argument("GEMM weight size does not match N x K");
+        }
+        switch (W.dtype()) {
+            case DType::F32:
+                detail::gemm<DType::F32>(A, M, K, W.data_as<DType::F32>(), N, bias, C, c_row, c_col);
+                break;
+            case DType::F16:
+                detail::gemm<DType::F16>(A, M, K, W.data_as<DType::F16>(), N, bias, C, c_row, c_col);
+                break;
+            case DType::BF16:
+                detail::gemm<DType::BF16>(A, M, K, W.data_as<DType::BF16>(), N, bias, C, c_row, c_col);
+                break;
+        }
+    }
+
+} // namespace nnm::gemm
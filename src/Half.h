@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <immintrin.h>
+
+namespace nnm {
+
+    // Element type of packed weights and activations. Compute always happens in float;
+    // the 16-bit types only change what is stored and streamed from memory.
+    enum class DType : uint8_t {
+        F32 = 0,
+        F16 = 1,
+        BF16 = 2,
+    };
+
+    inline size_t dtype_size(DType dtype) {
+        return dtype == DType::F32 ? sizeof(float) : sizeof(uint16_t);
+    }
+
+    inline std::string dtype_name(DType dtype) {
+        switch (dtype) {
+            case DType::F32:
+                return "f32";
+            case DType::F16:
+                return "f16";
+            case DType::BF16:
+                return "bf16";
+        }
+        throw std::invalid_argument("Unknown dtype");
+    }
+
+    inline DType dtype_from_name(const std::string &name) {
+        if (name == "f32") return DType::F32;
+        if (name == "f16") return DType::F16;
+        if (name == "bf16") return DType::BF16;
+        throw std::invalid_argument("Unknown dtype: " + name);
+    }
+
+    namespace half {
+
+        inline uint16_t float_to_f16(float value) {
+            return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+        }
+
+        inline float f16_to_float(uint16_t bits) {
+            return _cvtsh_ss(bits);
+        }
+
+        // Round to nearest even; NaNs keep a mantissa bit so they do not collapse into infinity.
+        inline uint16_t float_to_bf16(float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            if ((bits & 0x7fffffffu) > 0x7f800000u) {
+                return static_cast<uint16_t>((bits >> 16) | 0x40u);
+            }
+            bits += 0x7fffu + ((bits >> 16) & 1u);
+            return static_cast<uint16_t>(bits >> 16);
+        }
+
+        inline float bf16_to_float(uint16_t bits) {
+            uint32_t widened = static_cast<uint32_t>(bits) << 16;
+            float value;
+            std::memcpy(&value, &widened, sizeof(value));
+            return value;
+        }
+
+        // Storage type for each dtype, so kernels can be templated on the weight format.
+        template<DType D>
+        struct Storage {
+            using type = uint16_t;
+        };
+
+        template<>
+        struct Storage<DType::F32> {
+            using type = float;
+        };
+
+        template<DType D>
+        using storage_t = typename Storage<D>::type;
+
+        template<DType D>
+        inline float load1(const storage_t<D> *src) {
+            if constexpr (D == DType::F32) {
+                return *src;
+            } else if constexpr (D == DType::F16) {
+                return f16_to_float(*src);
+            } else {
+                return bf16_to_float(*src);
+            }
+        }
+
+        // Widens eight stored values to float lanes; F16 uses the F16C converter, BF16 is a shift.
+        template<DType D>
+        inline __m256 load8(const storage_t<D> *src) {
+            if constexpr (D == DType::F32) {
+                return _mm256_loadu_ps(src);
+            } else {
+                __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+                if constexpr (D == DType::F16) {
+                    return _mm256_cvtph_ps(raw);
+                } else {
+                    return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(raw), 16));
+                }
+            }
+        }
+
+        inline void to_float(const void *src, DType dtype, float *dst, size_t n) {
+            if (dtype == DType::F32) {
+                std::memcpy(dst, src, n * sizeof(float));
+                return;
+            }
+            const auto *in = static_cast<const uint16_t *>(src);
+            size_t i = 0;
+            if (dtype == DType::F16) {
+                for (; i + 8 <= n; i += 8) {
+                    _mm256_storeu_ps(dst + i, load8<DType::F16>(in + i));
+                }
+                for (; i < n; ++i) {
+                    dst[i] = f16_to_float(in[i]);
+                }
+            } else {
+                for (; i + 8 <= n; i += 8) {
+                    _mm256_storeu_ps(dst + i, load8<DType::BF16>(in + i));
+                }
+                for (; i < n; ++i) {
+                    dst[i] = bf16_to_float(in[i]);
+                }
+            }
+        }
+
+        inline void from_float(const float *src, DType dtype, void *dst, size_t n) {
+            if (dtype == DType::F32) {
+                std::memcpy(dst, src, n * sizeof(float));
+                return;
+            }
+            auto *out = static_cast<uint16_t *>(dst);
+            size_t i = 0;
+            if (dtype == DType::F16) {
+                for (; i + 8 <= n; i += 8) {
+                    __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), packed);
+                }
+                for (; i < n; ++i) {
+                    out[i] = float_to_f16(src[i]);
+                }
+            } else {
+                for (; i < n; ++i) {
+                    out[i] = float_to_bf16(src[i]);
+                }
+            }
+        }
+
+    } // namespace half
+
+} // namespace nnm
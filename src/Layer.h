@@ -8,9 +8,14 @@
 #include <memory>
 #include <string>
 #include <iostream>
+#include <functional>
+#include "Half.h"
+#include "PackedTensor.h"
 
 namespace nnm {
 
+    using ParameterVisitor = std::function<void(const std::string &name, PackedTensor &tensor)>;
+
     template<typename InputType, typename OutputType>
     class Layer {
     public:
@@ -18,6 +23,27 @@ namespace nnm {
 
         virtual OutputType forward(const InputType &input) = 0;
 
+        // Layers that can work in place override this to reuse the buffer of a dying input.
+        virtual OutputType forward(InputType &&input) {
+            return forward(static_cast<const InputType &>(input));
+        }
+
+        // Repacks stored weights into the given precision. Layers without weights have nothing to do.
+        virtual void convert_weights(DType /*dtype*/) {}
+
+        // While on, quantizable layers record the range of their inputs for int8 calibration.
+        virtual void calibrate(bool /*enabled*/) {}
+
+        // Switches quantizable layers between the float path and the calibrated int8 path.
+        virtual void use_int8(bool /*enabled*/) {}
+
+        // Calls visit on every stored parameter, named like torch state_dict keys under prefix
+        // (e.g. "conv1.weight"). Visitors may replace a tensor, e.g. with one borrowed from a weight file.
+        virtual void visit_parameters(const std::string & /*prefix*/, const ParameterVisitor & /*visit*/) {}
+
+        // Bytes of weight storage, so callers can see what a precision change saves.
+        virtual size_t weight_bytes() const { return 0; }
+
         virtual std::string get_name() const = 0;
 
         virtual size_t get_input_size() const = 0;
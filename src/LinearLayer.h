@@ -2,70 +2,91 @@
 
 #include "Layer.h"
 #include "Tensor4D.h"
+#include "PackedTensor.h"
+#include "Gemm.h"
+#include "Quantization.h"
 #include <random>
 #include <cmath>
 #include <stdexcept>
-#include <iostream>
 
 namespace nnm {
 
     class LinearLayer : public Layer<Tensor4D, Tensor4D> {
     private:
-        Tensor4D weights;
-        Tensor4D bias;
+        PackedTensor weights;
+        PackedTensor bias;
+        quant::LayerQuantizer int8;
         size_t in_features;
         size_t out_features;
 
     public:
         LinearLayer(size_t in_features, size_t out_features)
-                : in_features(in_features), out_features(out_features),
-                  weights(1, out_features, in_features, 1),
-                  bias(1, out_features, 1, 1) {
+                : in_features(in_features), out_features(out_features) {
 
             // Xavier/Glorot initialization
             std::random_device rd;
             std::mt19937 gen(rd());
             std::uniform_real_distribution<> dis(-1.0 / std::sqrt(in_features), 1.0 / std::sqrt(in_features));
 
+            Tensor4D initial(1, out_features, in_features, 1);
             for (size_t i = 0; i < out_features; ++i) {
                 for (size_t j = 0; j < in_features; ++j) {
-                    weights(0, i, j, 0) = dis(gen);
+                    initial(0, i, j, 0) = dis(gen);
                 }
-                bias(0, i, 0, 0) = 0.0f;
             }
+            weights = PackedTensor(initial, DType::F32);
+            bias = PackedTensor(Tensor4D(1, out_features, 1, 1), DType::F32);
         }
 
+        // Accepts (N, C, H, W) with C * H * W == in_features, or the (1, rows, in_features, 1) layout
+        // produced by Flatten. Either way each row is one sample and the output is (rows, out_features, 1, 1).
         Tensor4D forward(const Tensor4D &input) override {
-            size_t batch_size = input.getBatchSize();
+            size_t rows = input.getBatchSize();
             size_t input_size = input.getChannels() * input.getHeight() * input.getWidth();
 
             if (input_size != in_features) {
-                throw std::invalid_argument("Input size does not match layer's in_features");
-            }
-
-            std::cout << "Input dimensions: " << input.getBatchSize() << "x" << input.getChannels()
-                      << "x" << input.getHeight() << "x" << input.getWidth() << std::endl;
-            std::cout << "Weight dimensions: " << weights.getBatchSize() << "x" << weights.getChannels()
-                      << "x" << weights.getHeight() << "x" << weights.getWidth() << std::endl;
-
-            Tensor4D output(batch_size, out_features, 1, 1);
-
-            for (size_t n = 0; n < batch_size; ++n) {
-                for (size_t j = 0; j < out_features; ++j) {
-                    float result = 0.0f;
-                    for (size_t i = 0; i < in_features; ++i) {
-                        size_t c = i / (input.getHeight() * input.getWidth());
-                        size_t h = (i % (input.getHeight() * input.getWidth())) / input.getWidth();
-                        size_t w = (i % (input.getHeight() * input.getWidth())) % input.getWidth();
-                        result += input(n, c, h, w) * weights(0, j, i, 0);
-                    }
-                    output(n, j, 0, 0) = result + bias(0, j, 0, 0);
+                if (input.getBatchSize() == 1 && input.getHeight() == in_features && input.getWidth() == 1) {
+                    rows = input.getChannels();
+                } else {
+                    throw std::invalid_argument("Input size does not match layer's in_features");
                 }
             }
 
+            Tensor4D output(rows, out_features, 1, 1);
+            int8.observe(input);
+            if (int8.active()) {
+                int8.gemm(input.getData().data(), rows, in_features, bias.data_as<DType::F32>(),
+                          output.getData().data(), out_features, 1);
+            } else {
+                gemm::gemm_nt(input.getData().data(), rows, in_features, weights, out_features,
+                              bias.data_as<DType::F32>(), output.getData().data(), out_features, 1);
+            }
             return output;
         }
 
+        void convert_weights(DType dtype) override {
+            weights = weights.converted(dtype);
+        }
+
+        void calibrate(bool enabled) override {
+            int8.calibrate(enabled);
+        }
+
+        void use_int8(bool enabled) override {
+            int8.enable(enabled, weights, out_features, in_features);
+        }
+
+        size_t weight_bytes() const override {
+            return weights.nbytes() + bias.nbytes();
+        }
+
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            visit(prefix + "weight", weights);
+            visit(prefix + "bias", bias);
+            bias = bias.converted(DType::F32);
+            int8.refresh(weights, out_features, in_features);
+        }
+
         std::string get_name() const override {
             return "LinearLayer";
         }
@@ -78,12 +99,16 @@ namespace nnm {
             return out_features;
         }
 
-        const Tensor4D &get_weights() const {
+        Tensor4D get_weights() const {
+            return weights.toTensor();
+        }
+
+        const PackedTensor &get_packed_weights() const {
             return weights;
         }
 
-        const Tensor4D &get_bias() const {
-            return bias;
+        Tensor4D get_bias() const {
+            return bias.toTensor();
         }
 
         void set_weights(const Tensor4D &new_weights) {
@@ -93,7 +118,8 @@ namespace nnm {
                 new_weights.getWidth() != 1) {
                 throw std::invalid_argument("New weights dimensions do not match layer dimensions");
             }
-            weights = new_weights;
+            weights = PackedTensor(new_weights, weights.dtype());
+            int8.refresh(weights, out_features, in_features);
         }
 
         void set_bias(const Tensor4D &new_bias) {
@@ -103,7 +129,7 @@ namespace nnm {
                 new_bias.getWidth() != 1) {
                 throw std::invalid_argument("New bias dimensions do not match layer dimensions");
             }
-            bias = new_bias;
+            bias = PackedTensor(new_bias, DType::F32);
         }
     };
 
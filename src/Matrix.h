@@ -8,6 +8,8 @@
 #include <iostream>
 #include <cmath>
 #include <numeric>
+#include "ElementWise.h"
+#include "Reduction.h"
 #include "Vector.h"
 
 namespace nnm {
@@ -125,9 +127,8 @@ namespace nnm {
                 throw std::invalid_argument("Matrix dimensions do not match for addition");
             }
             Matrix result(rows, cols);
-            for (size_t i = 0; i < rows * cols; ++i) {
-                result.data[i] = data[i] + other.data[i];
-            }
+            elementwise::binary(result.data.data(), data.data(), other.data.data(), rows * cols,
+                                elementwise::Add{});
             return result;
         }
 
@@ -136,9 +137,8 @@ namespace nnm {
                 throw std::invalid_argument("Matrix dimensions do not match for subtraction");
             }
             Matrix result(rows, cols);
-            for (size_t i = 0; i < rows * cols; ++i) {
-                result.data[i] = data[i] - other.data[i];
-            }
+            elementwise::binary(result.data.data(), data.data(), other.data.data(), rows * cols,
+                                elementwise::Sub{});
             return result;
         }
 
@@ -206,14 +206,15 @@ namespace nnm {
                 throw std::invalid_argument("Matrix dimensions do not match for element-wise multiplication");
             }
             Matrix result(rows, cols);
-            for (size_t i = 0; i < rows * cols; ++i) {
-                result.data[i] = data[i] * other.data[i];
-            }
+            elementwise::binary(result.data.data(), data.data(), other.data.data(), rows * cols,
+                                elementwise::Mul{});
             return result;
         }
 
         [[nodiscard]] float sum() const {
-            return std::accumulate(data.begin(), data.end(), 0.0f);
+            float result;
+            reduction::sum(data.data(), {1, 1, rows, cols}, reduction::ALL, &result);
+            return result;
         }
 
 
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include "Half.h"
+#include "Tensor4D.h"
+
+namespace nnm {
+
+    // A read-only 4D tensor stored as f32, f16 or bf16. Layers keep their weights in this form and
+    // expand them to float inside the kernels; activations can be packed the same way for storage.
+    // The buffer is either owned or borrowed from an owner (e.g. a mapped file) that it keeps alive.
+    class PackedTensor {
+    private:
+        static constexpr size_t ALIGNMENT = 64;
+
+        elementwise::Shape4 dims{0, 0, 0, 0};
+        DType type = DType::F32;
+        std::shared_ptr<const void> owner;
+        const void *ptr = nullptr;
+
+        static std::shared_ptr<void> allocate(size_t bytes) {
+            void *memory = ::operator new(bytes == 0 ? ALIGNMENT : bytes, std::align_val_t(ALIGNMENT));
+            return {memory, [](void *p) { ::operator delete(p, std::align_val_t(ALIGNMENT)); }};
+        }
+
+    public:
+        PackedTensor() = default;
+
+        PackedTensor(const Tensor4D &tensor, DType dtype) : dims(tensor.shape()), type(dtype) {
+            std::shared_ptr<void> buffer = allocate(nbytes());
+            half::from_float(tensor.getData().data(), dtype, buffer.get(), size());
+            ptr = buffer.get();
+            owner = std::move(buffer);
+        }
+
+        // Wraps memory owned by someone else; owner is held for as long as this tensor lives.
+        static PackedTensor borrow(const void *data, DType dtype, const elementwise::Shape4 &shape,
+                                   std::shared_ptr<const void> owner) {
+            PackedTensor result;
+            result.dims = shape;
+            result.type = dtype;
+            result.ptr = data;
+            result.owner = std::move(owner);
+            return result;
+        }
+
+        [[nodiscard]] PackedTensor converted(DType dtype) const {
+            if (dtype == type) {
+                return *this;
+            }
+            return {toTensor(), dtype};
+        }
+
+        [[nodiscard]] Tensor4D toTensor() const {
+            Tensor4D result(dims);
+            half::to_float(ptr, type, result.getData().data(), size());
+            return result;
+        }
+
+        [[nodiscard]] DType dtype() const { return type; }
+
+        [[nodiscard]] const elementwise::Shape4 &shape() const { return dims; }
+
+        [[nodiscard]] size_t size() const { return elementwise::numel(dims); }
+
+        [[nodiscard]] size_t nbytes() const { return size() * dtype_size(type); }
+
+        [[nodiscard]] bool empty() const { return ptr == nullptr; }
+
+        [[nodiscard]] const void *data() const { return ptr; }
+
+        template<DType D>
+        [[nodiscard]] const half::storage_t<D> *data_as() const {
+            if (D != type) {
+                throw std::invalid_argument("PackedTensor accessed as " + dtype_name(D) +
+                                            " but stores " + dtype_name(type));
+            }
+            return static_cast<const half::storage_t<D> *>(ptr);
+        }
+    };
+
+} // namespace nnm
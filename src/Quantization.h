@@ -0,0 +1,339 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include <immintrin.h>
+#include "PackedTensor.h"
+#include "Tensor4D.h"
+
+namespace nnm::quant {
+
+    // Activations use 0..127 rather than the full u8 range: maddubs adds two u8 * s8 products into
+    // a saturating int16, and 2 * 127 * 127 is the largest sum that cannot saturate.
+    constexpr int32_t ACTIVATION_MAX = 127;
+    constexpr int32_t WEIGHT_MAX = 127;
+    // The reduction dimension is padded to one AVX2 register of bytes.
+    constexpr size_t K_ALIGN = 32;
+    constexpr size_t MR = 2;
+    constexpr size_t NR = 4;
+    constexpr size_t PARALLEL_WORK = 1 << 18;
+
+    inline size_t padded(size_t k) {
+        return (k + K_ALIGN - 1) / K_ALIGN * K_ALIGN;
+    }
+
+    // Running min/max of everything a layer saw during calibration.
+    struct ActivationObserver {
+        float min = std::numeric_limits<float>::infinity();
+        float max = -std::numeric_limits<float>::infinity();
+
+        void observe(const float *data, size_t n) {
+            for (size_t i = 0; i < n; ++i) {
+                min = std::min(min, data[i]);
+                max = std::max(max, data[i]);
+            }
+        }
+
+        [[nodiscard]] bool empty() const { return min > max; }
+    };
+
+    // Affine u8 quantization of activations: x ~= scale * (q - zero_point).
+    struct ActivationQuant {
+        float scale = 1.0f;
+        int32_t zero_point = 0;
+
+        // The range is widened to contain zero so that zero padding is represented exactly.
+        static ActivationQuant fromRange(float min, float max) {
+            min = std::min(min, 0.0f);
+            max = std::max(max, 0.0f);
+            ActivationQuant result;
+            if (max > min) {
+                result.scale = (max - min) / static_cast<float>(ACTIVATION_MAX);
+                result.zero_point = std::clamp(static_cast<int32_t>(std::lround(-min / result.scale)),
+                                               0, ACTIVATION_MAX);
+            }
+            return result;
+        }
+    };
+
+    // Per-output-channel symmetric int8 weights, rows padded with zeros to a multiple of K_ALIGN.
+    // row_sums lets the kernel remove the activation zero point after the integer product.
+    struct QuantizedWeights {
+        size_t rows = 0;
+        size_t k = 0;
+        size_t k_padded = 0;
+        std::vector<int8_t> data;
+        std::vector<float> scales;
+        std::vector<int32_t> row_sums;
+
+        QuantizedWeights() = default;
+
+        QuantizedWeights(const PackedTensor &weights, size_t rows, size_t k)
+                : rows(rows), k(k), k_padded(padded(k)), data(rows * padded(k), 0), scales(rows, 1.0f),
+                  row_sums(rows, 0) {
+            if (weights.size() != rows * k) {
+                throw std::invalid_argument("Quantized weight size does not match rows x k");
+            }
+            Tensor4D full = weights.toTensor();
+            const float *w = full.getData().data();
+            for (size_t r = 0; r < rows; ++r) {
+                const float *row = w + r * k;
+                float amax = 0.0f;
+                for (size_t i = 0; i < k; ++i) {
+                    amax = std::max(amax, std::abs(row[i]));
+                }
+                if (amax > 0.0f) {
+                    scales[r] = amax / static_cast<float>(WEIGHT_MAX);
+                }
+                for (size_t i = 0; i < k; ++i) {
+                    int32_t q = std::clamp(static_cast<int32_t>(std::lround(row[i] / scales[r])),
+                                           -WEIGHT_MAX, WEIGHT_MAX);
+                    data[r * k_padded + i] = static_cast<int8_t>(q);
+                    row_sums[r] += q;
+                }
+            }
+        }
+    };
+
+    // Quantizes M rows of K floats into u8 rows of length padded(K); padding bytes are zero.
+    inline void quantizeRows(const float *in, size_t M, size_t K, const ActivationQuant &q, uint8_t *out) {
+        const size_t Kp = padded(K);
+        const float inv_scale = 1.0f / q.scale;
+        // Scaled values are clamped while still float: past the int32 range cvtps_epi32 returns
+        // 0x80000000, which would turn a huge activation into 0 instead of saturating it.
+        const float lo = static_cast<float>(-q.zero_point);
+        const float hi = static_cast<float>(ACTIVATION_MAX - q.zero_point);
+        const __m256 vinv = _mm256_set1_ps(inv_scale);
+        const __m256 vlo = _mm256_set1_ps(lo);
+        const __m256 vhi = _mm256_set1_ps(hi);
+        const __m256i vzp = _mm256_set1_epi32(q.zero_point);
+        // packs/packus interleave 128-bit lanes; this restores element order.
+        const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+        auto convert = [&](const float *p) {
+            __m256 v = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(p), vinv), vlo), vhi);
+            return _mm256_add_epi32(_mm256_cvtps_epi32(v), vzp);
+        };
+
+        for (size_t m = 0; m < M; ++m) {
+            const float *row = in + m * K;
+            uint8_t *dst = out + m * Kp;
+            size_t i = 0;
+            for (; i + 32 <= K; i += 32) {
+                __m256i lo = _mm256_packs_epi32(convert(row + i), convert(row + i + 8));
+                __m256i hi = _mm256_packs_epi32(convert(row + i + 16), convert(row + i + 24));
+                __m256i bytes = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), bytes);
+            }
+            for (; i < K; ++i) {
+                float v = std::clamp(row[i] * inv_scale, lo, hi);
+                dst[i] = static_cast<uint8_t>(static_cast<int32_t>(std::nearbyint(v)) + q.zero_point);
+            }
+            std::fill(dst + K, dst + Kp, 0);
+        }
+    }
+
+    namespace detail {
+
+        inline int32_t hsum(__m256i v) {
+            __m128i lo = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+            lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(1, 0, 3, 2)));
+            lo = _mm_add_epi32(lo, _mm_shuffle_epi32(lo, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtsi128_si32(lo);
+        }
+
+        template<size_t R, size_t S>
+        void tile(const uint8_t *A, const int8_t *W, size_t Kp, const QuantizedWeights &weights, size_t n0,
+                  const ActivationQuant &q, const float *bias, float *C, size_t c_row, size_t c_col) {
+            const __m256i ones = _mm256_set1_epi16(1);
+            __m256i acc[R][S];
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < S; ++j) {
+                    acc[i][j] = _mm256_setzero_si256();
+                }
+            }
+
+            for (size_t k = 0; k < Kp; k += K_ALIGN) {
+                __m256i w[S];
+                for (size_t j = 0; j < S; ++j) {
+                    w[j] = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(W + j * Kp + k));
+                }
+                for (size_t i = 0; i < R; ++i) {
+                    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(A + i * Kp + k));
+                    for (size_t j = 0; j < S; ++j) {
+                        __m256i pairs = _mm256_maddubs_epi16(a, w[j]);
+                        acc[i][j] = _mm256_add_epi32(acc[i][j], _mm256_madd_epi16(pairs, ones));
+                    }
+                }
+            }
+
+            // Requantization back to float is fused with the zero-point correction and the bias.
+            for (size_t i = 0; i < R; ++i) {
+                for (size_t j = 0; j < S; ++j) {
+                    size_t n = n0 + j;
+                    int32_t total = hsum(acc[i][j]) - q.zero_point * weights.row_sums[n];
+                    C[i * c_row + j * c_col] = static_cast<float>(total) * q.scale * weights.scales[n] +
+                                               (bias ? bias[n] : 0.0f);
+                }
+            }
+        }
+
+        template<size_t R, size_t S = NR>
+        void edgeTile(size_t cols, const uint8_t *A, const int8_t *W, size_t Kp, const QuantizedWeights &weights,
+                      size_t n0, const ActivationQuant &q, const float *bias, float *C, size_t c_row,
+                      size_t c_col) {
+            if constexpr (S == 0) {
+                return;
+            } else if (cols == S) {
+                tile<R, S>(A, W, Kp, weights, n0, q, bias, C, c_row, c_col);
+            } else {
+                edgeTile<R, S - 1>(cols, A, W, Kp, weights, n0, q, bias, C, c_row, c_col);
+            }
+        }
+
+    } // namespace detail
+
+    // C[m * c_row + n * c_col] = bias[n] + dequant(sum_k A[m, k] * W[n, k]), with A already quantized
+    // by quantizeRows using q. Mirrors gemm::gemm_nt so layers can switch paths without reshaping.
+    inline void gemm_u8s8(const uint8_t *A, size_t M, const QuantizedWeights &W, const ActivationQuant &q,
+                          const float *bias, float *C, size_t c_row, size_t c_col) {
+        const size_t N = W.rows;
+        const size_t Kp = W.k_padded;
+        const size_t row_tiles = (M + MR - 1) / MR;
+        const size_t col_tiles = (N + NR - 1) / NR;
+        const ptrdiff_t tiles = static_cast<ptrdiff_t>(row_tiles * col_tiles);
+
+#pragma omp parallel for schedule(static) if (M * N * Kp >= PARALLEL_WORK)
+        for (ptrdiff_t t = 0; t < tiles; ++t) {
+            size_t m = (static_cast<size_t>(t) / col_tiles) * MR;
+            size_t n = (static_cast<size_t>(t) % col_tiles) * NR;
+            size_t rows = std::min(MR, M - m);
+            size_t cols = std::min(NR, N - n);
+            const uint8_t *a = A + m * Kp;
+            const int8_t *w = W.data.data() + n * Kp;
+            float *c = C + m * c_row + n * c_col;
+            if (rows == MR) {
+                detail::edgeTile<MR>(cols, a, w, Kp, W, n, q, bias, c, c_row, c_col);
+            } else {
+                detail::edgeTile<1>(cols, a, w, Kp, W, n, q, bias, c, c_row, c_col);
+            }
+        }
+    }
+
+    // The int8 state a Conv or Linear layer carries: the calibration observer, and once enabled,
+    // the quantized weights and input parameters.
+    class LayerQuantizer {
+    private:
+        ActivationObserver observer;
+        bool calibrating = false;
+        bool enabled = false;
+        QuantizedWeights weights;
+        ActivationQuant input;
+
+    public:
+        void calibrate(bool on) {
+            if (on && !calibrating) {
+                observer = {};
+            }
+            calibrating = on;
+        }
+
+        void observe(const Tensor4D &x) {
+            if (calibrating) {
+                observer.observe(x.getData().data(), x.getData().size());
+            }
+        }
+
+        void enable(bool on, const PackedTensor &float_weights, size_t rows, size_t k) {
+            if (on && observer.empty()) {
+                throw std::invalid_argument("Layer has no calibration data for int8 inference");
+            }
+            enabled = on;
+            if (on) {
+                refresh(float_weights, rows, k);
+                input = ActivationQuant::fromRange(observer.min, observer.max);
+            }
+        }
+
+        // Requantizes after the float weights were replaced.
+        void refresh(const PackedTensor &float_weights, size_t rows, size_t k) {
+            if (enabled) {
+                weights = QuantizedWeights(float_weights, rows, k);
+            }
+        }
+
+        [[nodiscard]] bool active() const { return enabled; }
+
+        void gemm(const float *A, size_t M, size_t K, const float *bias, float *C, size_t c_row,
+                  size_t c_col) const {
+            std::vector<uint8_t> buffer(M * weights.k_padded);
+            quantizeRows(A, M, K, input, buffer.data());
+            gemm_u8s8(buffer.data(), M, weights, input, bias, C, c_row, c_col);
+        }
+    };
+
+    struct QuantizationReport {
+        size_t samples = 0;
+        float max_policy_error = 0.0f;
+        float mean_policy_error = 0.0f;
+        float max_value_error = 0.0f;
+        // Fraction of positions whose best move is the same under both paths.
+        float policy_agreement = 0.0f;
+    };
+
+    // Calibrates on the given positions, switches the model to int8 and reports how far its outputs
+    // move from the float path on the same positions. Works with any model returning (policy, value)
+    // that exposes calibrate() and use_int8(), e.g. ResNet and TicTacToeModel.
+    template<typename Model>
+    QuantizationReport quantize_model(Model &model, const std::vector<Tensor4D> &samples) {
+        if (samples.empty()) {
+            throw std::invalid_argument("Quantization needs at least one calibration sample");
+        }
+
+        model.use_int8(false);
+        model.calibrate(true);
+        std::vector<std::pair<Tensor4D, Tensor4D>> reference;
+        reference.reserve(samples.size());
+        for (const auto &sample: samples) {
+            reference.push_back(model.forward(sample));
+        }
+        model.calibrate(false);
+        model.use_int8(true);
+
+        QuantizationReport report;
+        size_t policy_values = 0, agreeing = 0, rows = 0;
+        double total_error = 0.0;
+        for (size_t s = 0; s < samples.size(); ++s) {
+            auto [policy, value] = model.forward(samples[s]);
+            const auto &[float_policy, float_value] = reference[s];
+            const auto &p = policy.getData(), &fp = float_policy.getData();
+            for (size_t i = 0; i < p.size(); ++i) {
+                float error = std::abs(p[i] - fp[i]);
+                report.max_policy_error = std::max(report.max_policy_error, error);
+                total_error += error;
+            }
+            policy_values += p.size();
+            for (size_t i = 0; i < value.getData().size(); ++i) {
+                report.max_value_error = std::max(report.max_value_error,
+                                                  std::abs(value.getData()[i] - float_value.getData()[i]));
+            }
+            std::vector<size_t> best = policy.argmax(reduction::C | reduction::H | reduction::W);
+            std::vector<size_t> float_best = float_policy.argmax(reduction::C | reduction::H | reduction::W);
+            for (size_t r = 0; r < best.size(); ++r) {
+                agreeing += best[r] == float_best[r];
+            }
+            rows += best.size();
+        }
+        report.samples = samples.size();
+        report.mean_policy_error = policy_values ? static_cast<float>(total_error / policy_values) : 0.0f;
+        report.policy_agreement = rows ? static_cast<float>(agreeing) / static_cast<float>(rows) : 0.0f;
+        return report;
+    }
+
+} // namespace nnm::quant
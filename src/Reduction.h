@@ -0,0 +1,536 @@
+#pragma once
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <immintrin.h>
+#include <omp.h>
+#include "ElementWise.h"
+
+namespace nnm::reduction {
+
+    using elementwise::Shape4;
+
+    // Axis bits; combine with | to reduce over several dimensions at once.
+    enum Axes : unsigned {
+        N = 1u, C = 2u, H = 4u, W = 8u, ALL = 15u
+    };
+
+    struct Options {
+        // When a few outputs each reduce a large extent, the extent itself is split across threads.
+        // By default the split follows the thread count, so the rounding of sums changes with it.
+        // Deterministic mode splits into fixed-size chunks and combines them in a fixed tree, so
+        // results are bit-identical for any number of threads.
+        bool deterministic = false;
+    };
+
+    // Contiguous runs up to this length are summed directly with 32 independent SIMD lanes;
+    // longer runs are split pairwise first, which keeps the error growth logarithmic.
+    constexpr size_t PAIRWISE_BLOCK = 1 << 11;
+    // Row-wise (inner dimension kept) sums over more rows than this switch to Kahan accumulation.
+    constexpr size_t KAHAN_ROWS = 32;
+    // Fixed chunk size of the deterministic split path.
+    constexpr size_t SPLIT_CHUNK = 1 << 14;
+    // The split path is used when fewer outputs than this share a large reduction.
+    constexpr size_t SPLIT_MAX_OUTPUTS = 16;
+
+    inline Shape4 reducedShape(const Shape4 &shape, unsigned axes) {
+        Shape4 result = shape;
+        for (size_t d = 0; d < 4; ++d) {
+            if (axes & (1u << d)) {
+                result[d] = 1;
+            }
+        }
+        return result;
+    }
+
+    inline size_t extent(const Shape4 &shape, unsigned axes) {
+        size_t result = 1;
+        for (size_t d = 0; d < 4; ++d) {
+            if (axes & (1u << d)) {
+                result *= shape[d];
+            }
+        }
+        return result;
+    }
+
+    namespace detail {
+
+        // Coalesced view of a reduction. Adjacent dimensions with the same role are merged, which
+        // leaves one of two shapes for the innermost (contiguous) run of length `inner`:
+        //  - inner_reduced: every output reduces reduced_offsets.size() contiguous segments,
+        //    output o starting at outer_offsets[o];
+        //  - otherwise: outputs come in blocks of `inner` contiguous values, block b starting at
+        //    outer_offsets[b], and each block accumulates reduced_offsets.size() rows elementwise.
+        // Offsets enumerate dimensions in row-major order, so argmax indices count the reduced
+        // elements in (N, C, H, W) order.
+        struct Plan {
+            bool inner_reduced = true;
+            size_t inner = 1;
+            std::vector<size_t> outer_offsets{0};
+            std::vector<size_t> reduced_offsets{0};
+
+            [[nodiscard]] size_t outputs() const {
+                return inner_reduced ? outer_offsets.size() : outer_offsets.size() * inner;
+            }
+        };
+
+        inline void expand(std::vector<size_t> &offsets, size_t size, size_t stride) {
+            std::vector<size_t> next;
+            next.reserve(offsets.size() * size);
+            for (size_t base: offsets) {
+                for (size_t i = 0; i < size; ++i) {
+                    next.push_back(base + i * stride);
+                }
+            }
+            offsets = std::move(next);
+        }
+
+        inline Plan makePlan(const Shape4 &shape, unsigned axes) {
+            struct Group {
+                size_t size;
+                size_t stride;
+                bool reduced;
+            };
+            std::vector<Group> groups;
+            size_t stride = elementwise::numel(shape);
+            for (size_t d = 0; d < 4; ++d) {
+                stride = shape[d] == 0 ? 0 : stride / shape[d];
+                if (shape[d] == 1) {
+                    continue;
+                }
+                bool reduced = (axes & (1u << d)) != 0;
+                if (!groups.empty() && groups.back().reduced == reduced) {
+                    groups.back().size *= shape[d];
+                    groups.back().stride = stride;
+                } else {
+                    groups.push_back({shape[d], stride, reduced});
+                }
+            }
+
+            Plan plan;
+            if (groups.empty()) {
+                return plan;
+            }
+            const Group &innermost = groups.back();
+            plan.inner_reduced = innermost.reduced;
+            plan.inner = innermost.size;
+            for (size_t g = 0; g + 1 < groups.size(); ++g) {
+                expand(groups[g].reduced ? plan.reduced_offsets : plan.outer_offsets, groups[g].size,
+                       groups[g].stride);
+            }
+            return plan;
+        }
+
+        inline float hsum(__m256 v) {
+            __m128 lo = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+            lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+            return _mm_cvtss_f32(lo);
+        }
+
+        inline float hmax(__m256 v) {
+            __m128 lo = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+            lo = _mm_max_ps(lo, _mm_movehl_ps(lo, lo));
+            lo = _mm_max_ss(lo, _mm_movehdup_ps(lo));
+            return _mm_cvtss_f32(lo);
+        }
+
+        struct Identity {
+            float operator()(float a) const { return a; }
+
+            __m256 operator()(__m256 a) const { return a; }
+        };
+
+        // exp(x - shift), the summand of logsumexp.
+        struct ExpShift {
+            float shift;
+
+            float operator()(float a) const { return std::exp(a - shift); }
+
+            __m256 operator()(__m256 a) const {
+                return elementwise::exp256(_mm256_sub_ps(a, _mm256_set1_ps(shift)));
+            }
+        };
+
+        template<typename F>
+        float simdSum(const float *p, size_t n, const F &f) {
+            __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+            __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                acc0 = _mm256_add_ps(acc0, f(_mm256_loadu_ps(p + i)));
+                acc1 = _mm256_add_ps(acc1, f(_mm256_loadu_ps(p + i + 8)));
+                acc2 = _mm256_add_ps(acc2, f(_mm256_loadu_ps(p + i + 16)));
+                acc3 = _mm256_add_ps(acc3, f(_mm256_loadu_ps(p + i + 24)));
+            }
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm256_add_ps(acc0, f(_mm256_loadu_ps(p + i)));
+            }
+            float total = hsum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+            for (; i < n; ++i) {
+                total += f(p[i]);
+            }
+            return total;
+        }
+
+        template<typename F>
+        float pairwiseSum(const float *p, size_t n, const F &f) {
+            if (n <= PAIRWISE_BLOCK) {
+                return simdSum(p, n, f);
+            }
+            size_t half = (n / 2) & ~size_t(31);
+            return pairwiseSum(p, half, f) + pairwiseSum(p + half, n - half, f);
+        }
+
+        inline float simdMax(const float *p, size_t n) {
+            const __m256 lowest = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+            __m256 acc0 = lowest, acc1 = lowest, acc2 = lowest, acc3 = lowest;
+            size_t i = 0;
+            for (; i + 32 <= n; i += 32) {
+                acc0 = _mm256_max_ps(acc0, _mm256_loadu_ps(p + i));
+                acc1 = _mm256_max_ps(acc1, _mm256_loadu_ps(p + i + 8));
+                acc2 = _mm256_max_ps(acc2, _mm256_loadu_ps(p + i + 16));
+                acc3 = _mm256_max_ps(acc3, _mm256_loadu_ps(p + i + 24));
+            }
+            for (; i + 8 <= n; i += 8) {
+                acc0 = _mm256_max_ps(acc0, _mm256_loadu_ps(p + i));
+            }
+            float best = hmax(_mm256_max_ps(_mm256_max_ps(acc0, acc1), _mm256_max_ps(acc2, acc3)));
+            for (; i < n; ++i) {
+                best = std::max(best, p[i]);
+            }
+            return best;
+        }
+
+        // First index of the maximum; the max is found with SIMD, then located with a compare scan.
+        inline std::pair<float, size_t> simdArgmax(const float *p, size_t n) {
+            float best = simdMax(p, n);
+            const __m256 target = _mm256_set1_ps(best);
+            size_t i = 0;
+            for (; i + 8 <= n; i += 8) {
+                int mask = _mm256_movemask_ps(_mm256_cmp_ps(_mm256_loadu_ps(p + i), target, _CMP_EQ_OQ));
+                if (mask) {
+                    return {best, i + static_cast<size_t>(__builtin_ctz(mask))};
+                }
+            }
+            for (; i < n; ++i) {
+                if (p[i] == best) {
+                    return {best, i};
+                }
+            }
+            return {best, 0};
+        }
+
+        // Pairwise combine of partial results in index order; the shape of the tree depends only
+        // on the number of partials.
+        template<typename T, typename Combine>
+        T treeCombine(std::vector<T> partials, const Combine &combine) {
+            for (size_t width = 1; width < partials.size(); width *= 2) {
+                for (size_t i = 0; i + width < partials.size(); i += 2 * width) {
+                    partials[i] = combine(partials[i], partials[i + width]);
+                }
+            }
+            return partials.front();
+        }
+
+        // Runs `chunk(begin, end)` over [0, total) split for the parallel path and returns the partials.
+        template<typename T, typename Chunk>
+        std::vector<T> splitPartials(size_t total, const Options &options, const Chunk &chunk) {
+            size_t pieces = options.deterministic
+                            ? (total + SPLIT_CHUNK - 1) / SPLIT_CHUNK
+                            : static_cast<size_t>(std::max(1, omp_get_max_threads()));
+            pieces = std::max<size_t>(1, std::min(pieces, total));
+            std::vector<T> partials(pieces);
+            const auto count = static_cast<ptrdiff_t>(pieces);
+#pragma omp parallel for schedule(static)
+            for (ptrdiff_t k = 0; k < count; ++k) {
+                size_t begin = options.deterministic ? static_cast<size_t>(k) * SPLIT_CHUNK
+                                                     : total * static_cast<size_t>(k) / pieces;
+                size_t end = options.deterministic ? std::min(total, begin + SPLIT_CHUNK)
+                                                   : total * static_cast<size_t>(k + 1) / pieces;
+                partials[k] = chunk(begin, end);
+            }
+            return partials;
+        }
+
+        inline bool useSplit(const Plan &plan) {
+            return plan.inner_reduced && plan.outputs() < SPLIT_MAX_OUTPUTS &&
+                   plan.reduced_offsets.size() * plan.inner >= elementwise::PARALLEL_THRESHOLD;
+        }
+
+        inline bool parallelOutputs(const Plan &plan) {
+            return plan.outputs() * plan.reduced_offsets.size() * plan.inner >= elementwise::PARALLEL_THRESHOLD;
+        }
+
+        // Visits the contiguous pieces of the flattened range [begin, end) of one output's segments.
+        template<typename Visit>
+        void forSegments(const Plan &plan, const float *base, size_t begin, size_t end, const Visit &visit) {
+            while (begin < end) {
+                size_t segment = begin / plan.inner;
+                size_t offset = begin % plan.inner;
+                size_t length = std::min(plan.inner - offset, end - begin);
+                visit(base + plan.reduced_offsets[segment] + offset, length, segment * plan.inner + offset);
+                begin += length;
+            }
+        }
+
+        // Sum of f(x) for every output of an inner-reduced plan; f may depend on the output.
+        template<typename MakeF>
+        void sumSegments(const Plan &plan, const float *in, float *out, const Options &options, const MakeF &make_f) {
+            const size_t total = plan.reduced_offsets.size() * plan.inner;
+            if (useSplit(plan)) {
+                for (size_t o = 0; o < plan.outer_offsets.size(); ++o) {
+                    const float *base = in + plan.outer_offsets[o];
+                    auto f = make_f(o);
+                    auto partials = splitPartials<double>(total, options, [&](size_t begin, size_t end) {
+                        double partial = 0.0;
+                        forSegments(plan, base, begin, end, [&](const float *p, size_t n, size_t) {
+                            partial += pairwiseSum(p, n, f);
+                        });
+                        return partial;
+                    });
+                    out[o] = static_cast<float>(treeCombine(std::move(partials), std::plus<double>()));
+                }
+                return;
+            }
+
+            const auto outputs = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+#pragma omp parallel for schedule(static) if (parallelOutputs(plan))
+            for (ptrdiff_t o = 0; o < outputs; ++o) {
+                const float *base = in + plan.outer_offsets[o];
+                auto f = make_f(static_cast<size_t>(o));
+                // Kahan compensation across segments; pairwise within each segment.
+                float sum = 0.0f, compensation = 0.0f;
+                for (size_t offset: plan.reduced_offsets) {
+                    float y = pairwiseSum(base + offset, plan.inner, f) - compensation;
+                    float t = sum + y;
+                    compensation = (t - sum) - y;
+                    sum = t;
+                }
+                out[o] = sum;
+            }
+        }
+
+        // Elementwise sum of f(x) over the rows of a plan whose inner dimension is kept.
+        template<typename MakeF>
+        void sumRows(const Plan &plan, const float *in, float *out, const MakeF &make_f) {
+            const size_t L = plan.inner;
+            const auto blocks = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+            const bool kahan = plan.reduced_offsets.size() > KAHAN_ROWS;
+#pragma omp parallel for schedule(static) if (parallelOutputs(plan))
+            for (ptrdiff_t b = 0; b < blocks; ++b) {
+                const float *base = in + plan.outer_offsets[b];
+                float *dst = out + static_cast<size_t>(b) * L;
+                size_t j = 0;
+                for (; j + 8 <= L; j += 8) {
+                    auto f = make_f(static_cast<size_t>(b) * L + j);
+                    __m256 sum = _mm256_setzero_ps(), compensation = _mm256_setzero_ps();
+                    for (size_t offset: plan.reduced_offsets) {
+                        __m256 x = f(_mm256_loadu_ps(base + offset + j));
+                        if (kahan) {
+                            __m256 y = _mm256_sub_ps(x, compensation);
+                            __m256 t = _mm256_add_ps(sum, y);
+                            compensation = _mm256_sub_ps(_mm256_sub_ps(t, sum), y);
+                            sum = t;
+                        } else {
+                            sum = _mm256_add_ps(sum, x);
+                        }
+                    }
+                    _mm256_storeu_ps(dst + j, sum);
+                }
+                for (; j < L; ++j) {
+                    auto f = make_f(static_cast<size_t>(b) * L + j);
+                    float sum = 0.0f, compensation = 0.0f;
+                    for (size_t offset: plan.reduced_offsets) {
+                        float y = f(base[offset + j]) - compensation;
+                        float t = sum + y;
+                        compensation = kahan ? (t - sum) - y : 0.0f;
+                        sum = t;
+                    }
+                    dst[j] = sum;
+                }
+            }
+        }
+
+    } // namespace detail
+
+    // Every reduction writes numel(reducedShape(shape, axes)) outputs in row-major order.
+
+    inline void sum(const float *in, const Shape4 &shape, unsigned axes, float *out, const Options &options = {}) {
+        detail::Plan plan = detail::makePlan(shape, axes);
+        auto identity = [](size_t) { return detail::Identity{}; };
+        if (plan.inner_reduced) {
+            detail::sumSegments(plan, in, out, options, identity);
+        } else {
+            detail::sumRows(plan, in, out, identity);
+        }
+    }
+
+    inline void mean(const float *in, const Shape4 &shape, unsigned axes, float *out, const Options &options = {}) {
+        sum(in, shape, axes, out, options);
+        const size_t outputs = elementwise::numel(reducedShape(shape, axes));
+        elementwise::unary(out, out, outputs, elementwise::Scale{1.0f / static_cast<float>(extent(shape, axes))});
+    }
+
+    inline void max(const float *in, const Shape4 &shape, unsigned axes, float *out, const Options &options = {}) {
+        detail::Plan plan = detail::makePlan(shape, axes);
+        const size_t L = plan.inner;
+        if (plan.inner_reduced) {
+            const size_t total = plan.reduced_offsets.size() * L;
+            if (detail::useSplit(plan)) {
+                for (size_t o = 0; o < plan.outer_offsets.size(); ++o) {
+                    const float *base = in + plan.outer_offsets[o];
+                    auto partials = detail::splitPartials<float>(total, options, [&](size_t begin, size_t end) {
+                        float partial = -std::numeric_limits<float>::infinity();
+                        detail::forSegments(plan, base, begin, end, [&](const float *p, size_t n, size_t) {
+                            partial = std::max(partial, detail::simdMax(p, n));
+                        });
+                        return partial;
+                    });
+                    out[o] = detail::treeCombine(std::move(partials), [](float a, float b) { return std::max(a, b); });
+                }
+                return;
+            }
+            const auto outputs = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+#pragma omp parallel for schedule(static) if (detail::parallelOutputs(plan))
+            for (ptrdiff_t o = 0; o < outputs; ++o) {
+                float best = -std::numeric_limits<float>::infinity();
+                for (size_t offset: plan.reduced_offsets) {
+                    best = std::max(best, detail::simdMax(in + plan.outer_offsets[o] + offset, L));
+                }
+                out[o] = best;
+            }
+            return;
+        }
+
+        const auto blocks = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+#pragma omp parallel for schedule(static) if (detail::parallelOutputs(plan))
+        for (ptrdiff_t b = 0; b < blocks; ++b) {
+            const float *base = in + plan.outer_offsets[b];
+            float *dst = out + static_cast<size_t>(b) * L;
+            elementwise::fill(dst, L, -std::numeric_limits<float>::infinity());
+            for (size_t offset: plan.reduced_offsets) {
+                elementwise::binary(dst, dst, base + offset, L, elementwise::Max{});
+            }
+        }
+    }
+
+    // Index of the first maximum within each reduced sub-tensor, counted in row-major order.
+    inline void argmax(const float *in, const Shape4 &shape, unsigned axes, size_t *out, const Options &options = {}) {
+        detail::Plan plan = detail::makePlan(shape, axes);
+        const size_t L = plan.inner;
+        using Best = std::pair<float, size_t>;
+        auto better = [](const Best &a, const Best &b) {
+            return (b.first > a.first || (b.first == a.first && b.second < a.second)) ? b : a;
+        };
+
+        if (plan.inner_reduced) {
+            const size_t total = plan.reduced_offsets.size() * L;
+            const auto outputs = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+            const bool split = detail::useSplit(plan);
+#pragma omp parallel for schedule(static) if (!split && detail::parallelOutputs(plan))
+            for (ptrdiff_t o = 0; o < outputs; ++o) {
+                const float *base = in + plan.outer_offsets[o];
+                auto chunk = [&](size_t begin, size_t end) {
+                    Best best{-std::numeric_limits<float>::infinity(), begin};
+                    detail::forSegments(plan, base, begin, end, [&](const float *p, size_t n, size_t index) {
+                        auto [value, i] = detail::simdArgmax(p, n);
+                        best = better(best, {value, index + i});
+                    });
+                    return best;
+                };
+                out[o] = split ? detail::treeCombine(detail::splitPartials<Best>(total, options, chunk), better).second
+                               : chunk(0, total).second;
+            }
+            return;
+        }
+
+        const auto blocks = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+#pragma omp parallel for schedule(static) if (detail::parallelOutputs(plan))
+        for (ptrdiff_t b = 0; b < blocks; ++b) {
+            const float *base = in + plan.outer_offsets[b];
+            size_t *dst = out + static_cast<size_t>(b) * L;
+            size_t j = 0;
+            for (; j + 8 <= L; j += 8) {
+                __m256 best = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+                __m256i best_row = _mm256_setzero_si256();
+                for (size_t r = 0; r < plan.reduced_offsets.size(); ++r) {
+                    __m256 x = _mm256_loadu_ps(base + plan.reduced_offsets[r] + j);
+                    __m256 greater = _mm256_cmp_ps(x, best, _CMP_GT_OQ);
+                    best = _mm256_blendv_ps(best, x, greater);
+                    best_row = _mm256_castps_si256(_mm256_blendv_ps(
+                            _mm256_castsi256_ps(best_row),
+                            _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int>(r))), greater));
+                }
+                alignas(32) int rows[8];
+                _mm256_store_si256(reinterpret_cast<__m256i *>(rows), best_row);
+                for (size_t k = 0; k < 8; ++k) {
+                    dst[j + k] = static_cast<size_t>(rows[k]);
+                }
+            }
+            for (; j < L; ++j) {
+                Best best{-std::numeric_limits<float>::infinity(), 0};
+                for (size_t r = 0; r < plan.reduced_offsets.size(); ++r) {
+                    best = better(best, {base[plan.reduced_offsets[r] + j], r});
+                }
+                dst[j] = best.second;
+            }
+        }
+    }
+
+    // log(sum(exp(x))) computed as m + log(sum(exp(x - m))) with m the maximum, so it never overflows.
+    inline void logsumexp(const float *in, const Shape4 &shape, unsigned axes, float *out,
+                          const Options &options = {}) {
+        const size_t outputs = elementwise::numel(reducedShape(shape, axes));
+        std::vector<float> maxima(outputs);
+        max(in, shape, axes, maxima.data(), options);
+
+        // A row of all -inf has no finite maximum; shifting it by 0 keeps exp() at 0.
+        std::vector<float> shifts(outputs);
+        for (size_t o = 0; o < outputs; ++o) {
+            shifts[o] = std::isfinite(maxima[o]) ? maxima[o] : 0.0f;
+        }
+
+        detail::Plan plan = detail::makePlan(shape, axes);
+        if (plan.inner_reduced) {
+            detail::sumSegments(plan, in, out, options, [&](size_t o) { return detail::ExpShift{shifts[o]}; });
+        } else {
+            // Each output column has its own shift, so the shifts are loaded as a vector per column block.
+            const size_t L = plan.inner;
+            const auto blocks = static_cast<ptrdiff_t>(plan.outer_offsets.size());
+#pragma omp parallel for schedule(static) if (detail::parallelOutputs(plan))
+            for (ptrdiff_t b = 0; b < blocks; ++b) {
+                const float *base = in + plan.outer_offsets[b];
+                const size_t first = static_cast<size_t>(b) * L;
+                size_t j = 0;
+                for (; j + 8 <= L; j += 8) {
+                    __m256 shift = _mm256_loadu_ps(shifts.data() + first + j);
+                    __m256 sum = _mm256_setzero_ps();
+                    for (size_t offset: plan.reduced_offsets) {
+                        __m256 x = _mm256_sub_ps(_mm256_loadu_ps(base + offset + j), shift);
+                        sum = _mm256_add_ps(sum, elementwise::exp256(x));
+                    }
+                    _mm256_storeu_ps(out + first + j, sum);
+                }
+                for (; j < L; ++j) {
+                    detail::ExpShift f{shifts[first + j]};
+                    float sum = 0.0f;
+                    for (size_t offset: plan.reduced_offsets) {
+                        sum += f(base[offset + j]);
+                    }
+                    out[first + j] = sum;
+                }
+            }
+        }
+
+        for (size_t o = 0; o < outputs; ++o) {
+            out[o] = std::isfinite(maxima[o]) ? maxima[o] + std::log(out[o]) : maxima[o];
+        }
+    }
+
+} // namespace nnm::reduction
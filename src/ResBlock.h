@@ -26,13 +26,36 @@ namespace nnm {
         }
 
         Tensor4D forward(const Tensor4D &input) override {
-            Tensor4D x = input;
-            Tensor4D residual = x;
-            x = relu->forward(bn1->forward(conv1->forward(x)));
+            Tensor4D x = relu->forward(bn1->forward(conv1->forward(input)));
             x = bn2->forward(conv2->forward(x));
-            x = x + residual;  // Assuming Tensor4D supports element-wise addition
-            x = relu->forward(x);
-            return x;
+            x += input;
+            return relu->forward(std::move(x));
+        }
+
+        void convert_weights(DType dtype) override {
+            conv1->convert_weights(dtype);
+            conv2->convert_weights(dtype);
+        }
+
+        void calibrate(bool enabled) override {
+            conv1->calibrate(enabled);
+            conv2->calibrate(enabled);
+        }
+
+        void use_int8(bool enabled) override {
+            conv1->use_int8(enabled);
+            conv2->use_int8(enabled);
+        }
+
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            conv1->visit_parameters(prefix + "conv1.", visit);
+            bn1->visit_parameters(prefix + "bn1.", visit);
+            conv2->visit_parameters(prefix + "conv2.", visit);
+            bn2->visit_parameters(prefix + "bn2.", visit);
+        }
+
+        size_t weight_bytes() const override {
+            return conv1->weight_bytes() + bn1->weight_bytes() + conv2->weight_bytes() + bn2->weight_bytes();
         }
 
         std::string get_name() const override { return "ResBlock"; }
@@ -7,6 +7,7 @@
 #include "FlattenLayer.h"
 #include "LinearLayer.h"
 #include "Tanh.h"
+#include "WeightFile.h"
 
 namespace nnm {
 
@@ -54,13 +55,66 @@ namespace nnm {
             Tensor4D x = startBlock->forward(input);
 
             for (const auto &resBlock: backBone) {
-                x = resBlock->forward(x);
+                x = resBlock->forward(std::move(x));
             }
 
             Tensor4D policy = policyHead->forward(x);
 
-            Tensor4D value = valueHead->forward(x);
-            return {policy, value};
+            Tensor4D value = valueHead->forward(std::move(x));
+            return {std::move(policy), std::move(value)};
+        }
+
+        // Stores every convolution and linear weight in the given precision, e.g. DType::F16 to halve
+        // the bytes read per inference. Activations and accumulation stay in float.
+        void convert_weights(DType dtype) override {
+            startBlock->convert_weights(dtype);
+            for (const auto &resBlock: backBone) {
+                resBlock->convert_weights(dtype);
+            }
+            policyHead->convert_weights(dtype);
+            valueHead->convert_weights(dtype);
+        }
+
+        void calibrate(bool enabled) override {
+            startBlock->calibrate(enabled);
+            for (const auto &resBlock: backBone) {
+                resBlock->calibrate(enabled);
+            }
+            policyHead->calibrate(enabled);
+            valueHead->calibrate(enabled);
+        }
+
+        // Runs every convolution and linear layer in int8 using the ranges recorded by calibrate().
+        // quant::quantize_model does both steps and reports the accuracy cost.
+        void use_int8(bool enabled) override {
+            startBlock->use_int8(enabled);
+            for (const auto &resBlock: backBone) {
+                resBlock->use_int8(enabled);
+            }
+            policyHead->use_int8(enabled);
+            valueHead->use_int8(enabled);
+        }
+
+        // Parameters are borrowed from the mapped file, so this costs the same at any model size.
+        void load(const WeightFile &file) {
+            load_weights(*this, file);
+        }
+
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            startBlock->visit_parameters(prefix + "startBlock.", visit);
+            for (size_t i = 0; i < backBone.size(); ++i) {
+                backBone[i]->visit_parameters(prefix + "backBone." + std::to_string(i) + ".", visit);
+            }
+            policyHead->visit_parameters(prefix + "policyHead.", visit);
+            valueHead->visit_parameters(prefix + "valueHead.", visit);
+        }
+
+        size_t weight_bytes() const override {
+            size_t total = startBlock->weight_bytes() + policyHead->weight_bytes() + valueHead->weight_bytes();
+            for (const auto &resBlock: backBone) {
+                total += resBlock->weight_bytes();
+            }
+            return total;
         }
 
         std::string get_name() const override {
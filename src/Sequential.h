@@ -32,13 +32,57 @@ namespace nnm {
         }
 
         Tensor4D forward(const Tensor4D &input) override {
-            Tensor4D output = input;
+            if (layers.empty()) {
+                return input;
+            }
+            Tensor4D output = layers.front()->forward(input);
+            for (size_t i = 1; i < layers.size(); ++i) {
+                output = layers[i]->forward(std::move(output));
+            }
+            return output;
+        }
+
+        Tensor4D forward(Tensor4D &&input) override {
+            Tensor4D output = std::move(input);
             for (const auto &layer: layers) {
-                output = layer->forward(output);
+                output = layer->forward(std::move(output));
             }
             return output;
         }
 
+        void convert_weights(DType dtype) override {
+            for (const auto &layer: layers) {
+                layer->convert_weights(dtype);
+            }
+        }
+
+        void calibrate(bool enabled) override {
+            for (const auto &layer: layers) {
+                layer->calibrate(enabled);
+            }
+        }
+
+        void use_int8(bool enabled) override {
+            for (const auto &layer: layers) {
+                layer->use_int8(enabled);
+            }
+        }
+
+        // Children are numbered by position, as in torch.nn.Sequential.
+        void visit_parameters(const std::string &prefix, const ParameterVisitor &visit) override {
+            for (size_t i = 0; i < layers.size(); ++i) {
+                layers[i]->visit_parameters(prefix + std::to_string(i) + ".", visit);
+            }
+        }
+
+        size_t weight_bytes() const override {
+            size_t total = 0;
+            for (const auto &layer: layers) {
+                total += layer->weight_bytes();
+            }
+            return total;
+        }
+
         std::string get_name() const override {
             return "Sequential";
         }
@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <stdexcept>
 
 namespace nnm {
 
@@ -17,76 +18,19 @@ namespace nnm {
         SoftMaxLayer(int dimension = 1) : dimension(dimension) {}
 
         Tensor4D forward(const Tensor4D &input) override {
-            size_t batch_size = input.getBatchSize();
-            size_t channels = input.getChannels();
-            size_t height = input.getHeight();
-            size_t width = input.getWidth();
-
-            Tensor4D output(batch_size, channels, height, width);
+            return forward(Tensor4D(input));
+        }
 
-            for (size_t n = 0; n < batch_size; ++n) {
-                for (size_t c = 0; c < channels; ++c) {
-                    for (size_t h = 0; h < height; ++h) {
-                        for (size_t w = 0; w < width; ++w) {
-                            if (dimension == 0) {
-                                // Apply softmax along the batch dimension
-                                float max_val = -std::numeric_limits<float>::infinity();
-                                for (size_t b = 0; b < batch_size; ++b) {
-                                    max_val = std::max(max_val, input(b, c, h, w));
-                                }
-                                float sum_exp = 0.0f;
-                                for (size_t b = 0; b < batch_size; ++b) {
-                                    sum_exp += std::exp(input(b, c, h, w) - max_val);
-                                }
-                                for (size_t b = 0; b < batch_size; ++b) {
-                                    output(b, c, h, w) = std::exp(input(b, c, h, w) - max_val) / sum_exp;
-                                }
-                            } else if (dimension == 1) {
-                                // Apply softmax along the channels dimension
-                                float max_val = -std::numeric_limits<float>::infinity();
-                                for (size_t c = 0; c < channels; ++c) {
-                                    max_val = std::max(max_val, input(n, c, h, w));
-                                }
-                                float sum_exp = 0.0f;
-                                for (size_t c = 0; c < channels; ++c) {
-                                    sum_exp += std::exp(input(n, c, h, w) - max_val);
-                                }
-                                for (size_t c = 0; c < channels; ++c) {
-                                    output(n, c, h, w) = std::exp(input(n, c, h, w) - max_val) / sum_exp;
-                                }
-                            } else if (dimension == 2) {
-                                // Apply softmax along the height dimension
-                                float max_val = -std::numeric_limits<float>::infinity();
-                                for (size_t h = 0; h < height; ++h) {
-                                    max_val = std::max(max_val, input(n, c, h, w));
-                                }
-                                float sum_exp = 0.0f;
-                                for (size_t h = 0; h < height; ++h) {
-                                    sum_exp += std::exp(input(n, c, h, w) - max_val);
-                                }
-                                for (size_t h = 0; h < height; ++h) {
-                                    output(n, c, h, w) = std::exp(input(n, c, h, w) - max_val) / sum_exp;
-                                }
-                            } else if (dimension == 3) {
-                                // Apply softmax along the width dimension
-                                float max_val = -std::numeric_limits<float>::infinity();
-                                for (size_t w = 0; w < width; ++w) {
-                                    max_val = std::max(max_val, input(n, c, h, w));
-                                }
-                                float sum_exp = 0.0f;
-                                for (size_t w = 0; w < width; ++w) {
-                                    sum_exp += std::exp(input(n, c, h, w) - max_val);
-                                }
-                                for (size_t w = 0; w < width; ++w) {
-                                    output(n, c, h, w) = std::exp(input(n, c, h, w) - max_val) / sum_exp;
-                                }
-                            }
-                        }
-                    }
-                }
+        // exp(x - max) / sum(exp(x - max)) along `dimension`, computed in place.
+        Tensor4D forward(Tensor4D &&input) override {
+            if (dimension < 0 || dimension > 3) {
+                throw std::invalid_argument("SoftMaxLayer dimension must be between 0 and 3");
             }
+            const unsigned axis = 1u << dimension;
 
-            return output;
+            input.sub_(input.max(axis)).exp_();
+            input.div_(input.sum(axis));
+            return std::move(input);
         }
 
         std::string get_name() const override {
@@ -52,19 +52,14 @@ namespace nnm {
         Tanh() = default;
 
         Tensor4D forward(const Tensor4D &input) override {
-            Tensor4D output(input.getBatchSize(), input.getChannels(), input.getHeight(), input.getWidth());
-
-            for (size_t n = 0; n < input.getBatchSize(); ++n) {
-                for (size_t c = 0; c < input.getChannels(); ++c) {
-                    for (size_t h = 0; h < input.getHeight(); ++h) {
-                        for (size_t w = 0; w < input.getWidth(); ++w) {
-                            output(n, c, h, w) = static_cast<float>(tanh_impl(input(n, c, h, w)));
-                        }
-                    }
-                }
-            }
+            return forward(Tensor4D(input));
+        }
 
-            return output;
+        Tensor4D forward(Tensor4D &&input) override {
+            float *x = input.getData().data();
+            elementwise::unary(x, x, input.getData().size(),
+                               [](float v) { return static_cast<float>(tanh_impl(v)); });
+            return std::move(input);
         }
 
         std::string get_name() const override {
@@ -8,6 +8,10 @@
 #include <iostream>
 #include <cmath>
 #include <numeric>
+#include <limits>
+#include <string>
+#include "ElementWise.h"
+#include "Reduction.h"
 #include "Matrix.h"
 
 namespace nnm {
@@ -16,11 +20,35 @@ namespace nnm {
         std::vector<float> data;
         size_t batch_size, channels, height, width;
 
+        template<typename Op>
+        Tensor4D broadcastOp(const Tensor4D &other, Op op) const {
+            Tensor4D result(elementwise::broadcastShape(shape(), other.shape()));
+            elementwise::binary(result.data.data(), result.shape(), data.data(), shape(),
+                                other.data.data(), other.shape(), op);
+            return result;
+        }
+
+        template<typename Op>
+        Tensor4D &broadcastOp_(const Tensor4D &other, Op op, const char *operation) {
+            if (elementwise::broadcastShape(shape(), other.shape()) != shape()) {
+                throw std::invalid_argument(std::string("Tensor4D dimensions do not match for in-place ") + operation);
+            }
+            elementwise::binary(data.data(), shape(), data.data(), shape(), other.data.data(), other.shape(), op);
+            return *this;
+        }
+
+        [[nodiscard]] bool broadcastsTo(const Tensor4D &other) const {
+            return elementwise::broadcastShape(shape(), other.shape()) == shape();
+        }
+
     public:
         Tensor4D(size_t batch_size, size_t channels, size_t height, size_t width)
                 : batch_size(batch_size), channels(channels), height(height), width(width),
                   data(batch_size * channels * height * width, 0.0f) {}
 
+        explicit Tensor4D(const elementwise::Shape4 &shape)
+                : Tensor4D(shape[0], shape[1], shape[2], shape[3]) {}
+
         Tensor4D(size_t batch_size, size_t channels, size_t height, size_t width, float value)
                 : batch_size(batch_size), channels(channels), height(height), width(width),
                   data(batch_size * channels * height * width, value) {}
@@ -88,57 +116,138 @@ namespace nnm {
             return data[(n * channels * height * width) + (c * height * width) + (h * width) + w];
         }
 
-        Tensor4D operator+(const Tensor4D &other) const {
-            if (batch_size != other.batch_size || channels != other.channels ||
-                height != other.height || width != other.width) {
-                throw std::invalid_argument("Tensor4D.cpp dimensions do not match for addition");
-            }
-            Tensor4D result(batch_size, channels, height, width);
-            for (size_t i = 0; i < data.size(); ++i) {
-                result.data[i] = data[i] + other.data[i];
+        // Binary arithmetic broadcasts NumPy-style: every dimension must match or be 1 on one side.
+        Tensor4D operator+(const Tensor4D &other) const & {
+            return broadcastOp(other, elementwise::Add{});
+        }
+
+        Tensor4D operator+(const Tensor4D &other) && {
+            return broadcastsTo(other) ? std::move(add_(other)) : broadcastOp(other, elementwise::Add{});
+        }
+
+        Tensor4D operator-(const Tensor4D &other) const & {
+            return broadcastOp(other, elementwise::Sub{});
+        }
+
+        Tensor4D operator-(const Tensor4D &other) && {
+            return broadcastsTo(other) ? std::move(sub_(other)) : broadcastOp(other, elementwise::Sub{});
+        }
+
+        Tensor4D elementWiseMul(const Tensor4D &other) const & {
+            return broadcastOp(other, elementwise::Mul{});
+        }
+
+        Tensor4D elementWiseMul(const Tensor4D &other) && {
+            return broadcastsTo(other) ? std::move(mul_(other)) : broadcastOp(other, elementwise::Mul{});
+        }
+
+        Tensor4D &operator+=(const Tensor4D &other) { return add_(other); }
+
+        Tensor4D &operator-=(const Tensor4D &other) { return sub_(other); }
+
+        Tensor4D &operator*=(float scalar) { return mul_(scalar); }
+
+        // In-place operations. They reuse this tensor's buffer and return *this so that
+        // temporaries can be chained without allocating, e.g. std::move(x).add_(y).relu_().
+        // The right operand may broadcast to this tensor's shape, e.g. a (1, C, 1, 1) bias.
+        Tensor4D &add_(const Tensor4D &other) {
+            return broadcastOp_(other, elementwise::Add{}, "addition");
+        }
+
+        Tensor4D &sub_(const Tensor4D &other) {
+            return broadcastOp_(other, elementwise::Sub{}, "subtraction");
+        }
+
+        Tensor4D &mul_(const Tensor4D &other) {
+            return broadcastOp_(other, elementwise::Mul{}, "element-wise multiplication");
+        }
+
+        Tensor4D &div_(const Tensor4D &other) {
+            return broadcastOp_(other, elementwise::Div{}, "division");
+        }
+
+        Tensor4D &mul_(float scalar) {
+            elementwise::unary(data.data(), data.data(), data.size(), elementwise::Scale{scalar});
+            return *this;
+        }
+
+        Tensor4D &relu_() {
+            elementwise::unary(data.data(), data.data(), data.size(), elementwise::Relu{});
+            return *this;
+        }
+
+        Tensor4D &clamp_(float min_val, float max_val) {
+            if (min_val > max_val) {
+                throw std::invalid_argument("clamp_ requires min_val <= max_val");
             }
+            elementwise::unary(data.data(), data.data(), data.size(), elementwise::Clamp{min_val, max_val});
+            return *this;
+        }
+
+        Tensor4D &exp_() {
+            elementwise::unary(data.data(), data.data(), data.size(), elementwise::Exp{});
+            return *this;
+        }
 
+        Tensor4D &tanh_() {
+            elementwise::unary(data.data(), data.data(), data.size(), elementwise::Tanh{});
+            return *this;
+        }
+
+        float sum() const {
+            float result;
+            reduction::sum(data.data(), shape(), reduction::ALL, &result);
             return result;
         }
 
-        Tensor4D operator-(const Tensor4D &other) const {
-            if (batch_size != other.batch_size || channels != other.channels ||
-                height != other.height || width != other.width) {
-                throw std::invalid_argument("Tensor4D.cpp dimensions do not match for subtraction");
-            }
-            Tensor4D result(batch_size, channels, height, width);
-            for (size_t i = 0; i < data.size(); ++i) {
-                result.data[i] = data[i] - other.data[i];
+        float max() const {
+            if (data.empty()) {
+                throw std::invalid_argument("max of an empty Tensor4D");
             }
+            float result;
+            reduction::max(data.data(), shape(), reduction::ALL, &result);
             return result;
         }
 
-        Tensor4D elementWiseMul(const Tensor4D &other) const {
-            if (batch_size != other.batch_size || channels != other.channels ||
-                height != other.height || width != other.width) {
-                throw std::invalid_argument("Tensor4D.cpp dimensions do not match for element-wise multiplication");
-            }
-            Tensor4D result(batch_size, channels, height, width);
-            for (size_t i = 0; i < data.size(); ++i) {
-                result.data[i] = data[i] * other.data[i];
-            }
+        float mean() const {
+            return sum() / static_cast<float>(data.size());
+        }
+
+        // Reductions over any combination of axes, e.g. x.sum(reduction::N | reduction::H | reduction::W).
+        // Reduced dimensions are kept with size 1, so the result broadcasts against the input.
+        [[nodiscard]] Tensor4D sum(unsigned axes, const reduction::Options &options = {}) const {
+            Tensor4D result(reduction::reducedShape(shape(), axes));
+            reduction::sum(data.data(), shape(), axes, result.data.data(), options);
             return result;
         }
 
-        float sum() const {
-            return std::accumulate(data.begin(), data.end(), 0.0f);
+        [[nodiscard]] Tensor4D max(unsigned axes, const reduction::Options &options = {}) const {
+            Tensor4D result(reduction::reducedShape(shape(), axes));
+            reduction::max(data.data(), shape(), axes, result.data.data(), options);
+            return result;
         }
 
-        float max() const {
-            return *std::max_element(data.begin(), data.end());
+        [[nodiscard]] Tensor4D mean(unsigned axes, const reduction::Options &options = {}) const {
+            Tensor4D result(reduction::reducedShape(shape(), axes));
+            reduction::mean(data.data(), shape(), axes, result.data.data(), options);
+            return result;
         }
 
-        float mean() const {
-            return std::accumulate(data.begin(), data.end(), 0.0f) / static_cast<float>(data.size());
+        [[nodiscard]] Tensor4D logsumexp(unsigned axes, const reduction::Options &options = {}) const {
+            Tensor4D result(reduction::reducedShape(shape(), axes));
+            reduction::logsumexp(data.data(), shape(), axes, result.data.data(), options);
+            return result;
+        }
+
+        // Row-major indices over the reduced dimensions, one per element of the reduced shape.
+        [[nodiscard]] std::vector<size_t> argmax(unsigned axes, const reduction::Options &options = {}) const {
+            std::vector<size_t> result(elementwise::numel(reduction::reducedShape(shape(), axes)));
+            reduction::argmax(data.data(), shape(), axes, result.data(), options);
+            return result;
         }
 
         void fill(float value) {
-            std::fill(data.begin(), data.end(), value);
+            elementwise::fill(data.data(), data.size(), value);
         }
 
         void print() const {
@@ -228,8 +337,9 @@ namespace nnm {
                 _mm256_storeu_ps(matrix_data + i, tensor_values);
             }
 
-            for (; i < num_elements; ++i) {
-                matrix_data[i] = tensor_data[i];
+            const size_t remaining = num_elements - i;
+            for (size_t k = 0; k < remaining; ++k) {
+                matrix_data[i + k] = tensor_data[i + k];
             }
 
             return result;
@@ -274,28 +384,43 @@ namespace nnm {
             return this->operator()(0, i, j, 0);
         }
 
-        Tensor4D operator*(float scalar) const {
-            Tensor4D result(batch_size, channels, height, width);
-            for (size_t i = 0; i < data.size(); ++i) {
-                result.data[i] = data[i] * scalar;
-            }
+        Tensor4D operator*(float scalar) const & {
+            Tensor4D result(shape());
+            elementwise::unary(result.data.data(), data.data(), data.size(), elementwise::Scale{scalar});
             return result;
         }
 
+        Tensor4D operator*(float scalar) && {
+            return std::move(mul_(scalar));
+        }
+
         friend Tensor4D operator*(float scalar, const Tensor4D &tensor) {
             return tensor * scalar;
         }
 
-        Tensor4D operator/(float scalar) const {
+        friend Tensor4D operator*(float scalar, Tensor4D &&tensor) {
+            return std::move(tensor) * scalar;
+        }
+
+        Tensor4D operator/(float scalar) const & {
             if (scalar == 0.0f) {
                 throw std::invalid_argument("Division by zero");
             }
             return (*this) * (1.0f / scalar);
         }
 
+        Tensor4D operator/(float scalar) && {
+            if (scalar == 0.0f) {
+                throw std::invalid_argument("Division by zero");
+            }
+            return std::move(*this) * (1.0f / scalar);
+        }
+
 
         size_t getBatchSize() const { return batch_size; }
 
+        elementwise::Shape4 shape() const { return {batch_size, channels, height, width}; }
+
         size_t getChannels() const { return channels; }
 
         size_t getHeight() const { return height; }
@@ -6,6 +6,7 @@
 #include <numeric>
 #include <immintrin.h>
 #include <cmath>
+#include "ElementWise.h"
 
 namespace nnm {
 
@@ -38,21 +39,7 @@ namespace nnm {
             }
 
             Vector result(size());
-            size_t i = 0;
-
-            // Use AVX2 operations for blocks of 8 elements
-            for (; i + 8 <= size(); i += 8) {
-                __m256 a = _mm256_loadu_ps(&data[i]);
-                __m256 b = _mm256_loadu_ps(&other.data[i]);
-                __m256 sum = _mm256_add_ps(a, b);
-                _mm256_storeu_ps(&result.data[i], sum);
-            }
-
-            // Handle the remaining elements
-            for (; i < size(); ++i) {
-                result[i] = data[i] + other[i];
-            }
-
+            elementwise::binary(result.data.data(), data.data(), other.data.data(), size(), elementwise::Add{});
             return result;
         }
 
@@ -91,37 +78,12 @@ namespace nnm {
 
         Vector operator*(float scalar) const {
             Vector result(size());
-            size_t i = 0;
-
-            // Use AVX2 operations for blocks of 8 elements
-            __m256 s = _mm256_set1_ps(scalar);
-            for (; i + 8 <= size(); i += 8) {
-                __m256 a = _mm256_loadu_ps(&data[i]);
-                __m256 product = _mm256_mul_ps(a, s);
-                _mm256_storeu_ps(&result.data[i], product);
-            }
-
-            // Handle the remaining elements
-            for (; i < size(); ++i) {
-                result[i] = data[i] * scalar;
-            }
-
+            elementwise::unary(result.data.data(), data.data(), size(), elementwise::Scale{scalar});
             return result;
         }
 
         void fill(float value) {
-            size_t i = 0;
-
-            // Use AVX2 operations for blocks of 8 elements
-            __m256 v = _mm256_set1_ps(value);
-            for (; i + 8 <= size(); i += 8) {
-                _mm256_storeu_ps(&data[i], v);
-            }
-
-            // Handle the remaining elements
-            for (; i < size(); ++i) {
-                data[i] = value;
-            }
+            elementwise::fill(data.data(), size(), value);
         }
 
     };
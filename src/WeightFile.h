@@ -0,0 +1,268 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "PackedTensor.h"
+
+namespace nnm {
+
+    // Binary weight file, little endian:
+    //
+    //   header   64 bytes   magic "NNMW", version, entry count, file size
+    //   table    128 bytes per entry: NUL-padded name, dtype, 4 dims, data offset
+    //   data     one blob per entry, each starting on a 64-byte boundary
+    //
+    // Names follow torch state_dict keys ("backBone.0.conv1.weight"), dims are the nnm 4D shapes.
+    namespace weight_file {
+
+        constexpr char MAGIC[4] = {'N', 'N', 'M', 'W'};
+        constexpr uint32_t VERSION = 1;
+        constexpr size_t ALIGNMENT = 64;
+        constexpr size_t NAME_SIZE = 80;
+
+        struct Header {
+            char magic[4];
+            uint32_t version;
+            uint32_t count;
+            uint32_t reserved;
+            uint64_t file_size;
+            uint8_t padding[40];
+        };
+
+        struct Entry {
+            char name[NAME_SIZE];
+            uint8_t dtype;
+            uint8_t padding[7];
+            uint64_t dims[4];
+            uint64_t offset;
+        };
+
+        static_assert(sizeof(Header) == 64, "weight file header must stay 64 bytes");
+        static_assert(sizeof(Entry) == 128, "weight file entries must stay 128 bytes");
+
+        inline uint64_t align(uint64_t offset) {
+            return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+        }
+
+        // Bytes taken by dims elements of element_size bytes each, or false when that overflows.
+        inline bool byte_size(const uint64_t (&dims)[4], uint64_t element_size, uint64_t &bytes) {
+            bytes = element_size;
+            for (uint64_t dim: dims) {
+                if (__builtin_mul_overflow(bytes, dim, &bytes)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    } // namespace weight_file
+
+    // A weight file mapped read-only into memory. Tensors handed out borrow the mapping, which stays
+    // alive until the last of them is released, so opening a file costs the same at any model size.
+    class WeightFile {
+    private:
+        struct Mapping {
+            void *base = nullptr;
+            size_t size = 0;
+
+            ~Mapping() {
+                if (base) {
+                    munmap(base, size);
+                }
+            }
+        };
+
+        std::shared_ptr<Mapping> mapping;
+        std::unordered_map<std::string, PackedTensor> tensors;
+        std::vector<std::string> order;
+
+    public:
+        static WeightFile open(const std::string &path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open weight file: " + path);
+            }
+            struct stat info{};
+            if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(weight_file::Header)) {
+                ::close(fd);
+                throw std::runtime_error("Weight file is truncated: " + path);
+            }
+
+            auto mapping = std::make_shared<Mapping>();
+            mapping->size = static_cast<size_t>(info.st_size);
+            void *base = mmap(nullptr, mapping->size, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (base == MAP_FAILED) {
+                throw std::runtime_error("Cannot map weight file: " + path);
+            }
+            mapping->base = base;
+
+            WeightFile file;
+            file.mapping = mapping;
+            file.parse(path);
+            return file;
+        }
+
+        [[nodiscard]] bool contains(const std::string &name) const {
+            return tensors.count(name) != 0;
+        }
+
+        // The tensor points into the mapping; no bytes are copied.
+        [[nodiscard]] const PackedTensor &get(const std::string &name) const {
+            auto it = tensors.find(name);
+            if (it == tensors.end()) {
+                throw std::invalid_argument("Weight file has no tensor named " + name);
+            }
+            return it->second;
+        }
+
+        // Entry names in file order.
+        [[nodiscard]] const std::vector<std::string> &names() const { return order; }
+
+        [[nodiscard]] size_t size() const { return order.size(); }
+
+    private:
+        void parse(const std::string &path) {
+            const auto *bytes = static_cast<const uint8_t *>(mapping->base);
+            weight_file::Header header{};
+            std::memcpy(&header, bytes, sizeof(header));
+            if (std::memcmp(header.magic, weight_file::MAGIC, sizeof(header.magic)) != 0) {
+                throw std::runtime_error("Not an nnm weight file: " + path);
+            }
+            if (header.version != weight_file::VERSION) {
+                throw std::runtime_error("Unsupported weight file version " + std::to_string(header.version) +
+                                         ": " + path);
+            }
+            if (header.file_size != mapping->size ||
+                sizeof(header) + header.count * sizeof(weight_file::Entry) > mapping->size) {
+                throw std::runtime_error("Weight file is truncated: " + path);
+            }
+
+            for (uint32_t i = 0; i < header.count; ++i) {
+                weight_file::Entry entry{};
+                std::memcpy(&entry, bytes + sizeof(header) + i * sizeof(entry), sizeof(entry));
+
+                std::string name(entry.name, strnlen(entry.name, weight_file::NAME_SIZE));
+                if (entry.dtype > static_cast<uint8_t>(DType::BF16)) {
+                    throw std::runtime_error("Unknown dtype for " + name + " in " + path);
+                }
+                auto dtype = static_cast<DType>(entry.dtype);
+                uint64_t nbytes = 0;
+                if (!weight_file::byte_size(entry.dims, dtype_size(dtype), nbytes)) {
+                    throw std::runtime_error("Shape too large for " + name + " in " + path);
+                }
+                // Compared without adding, so that neither side can wrap around.
+                if (entry.offset % weight_file::ALIGNMENT != 0 || entry.offset > mapping->size ||
+                    nbytes > mapping->size - entry.offset) {
+                    throw std::runtime_error("Bad data offset for " + name + " in " + path);
+                }
+                elementwise::Shape4 shape{entry.dims[0], entry.dims[1], entry.dims[2], entry.dims[3]};
+                if (!tensors.emplace(name, PackedTensor::borrow(bytes + entry.offset, dtype, shape, mapping)).second) {
+                    throw std::runtime_error("Duplicate tensor " + name + " in " + path);
+                }
+                order.push_back(std::move(name));
+            }
+        }
+    };
+
+    // Collects named tensors and writes them in the WeightFile layout.
+    class WeightFileWriter {
+    private:
+        std::vector<std::pair<std::string, PackedTensor>> entries;
+
+    public:
+        void add(const std::string &name, const PackedTensor &tensor) {
+            if (name.empty() || name.size() >= weight_file::NAME_SIZE) {
+                throw std::invalid_argument("Weight name must be 1 to " +
+                                            std::to_string(weight_file::NAME_SIZE - 1) + " characters: " + name);
+            }
+            for (const auto &entry: entries) {
+                if (entry.first == name) {
+                    throw std::invalid_argument("Duplicate weight name: " + name);
+                }
+            }
+            entries.emplace_back(name, tensor);
+        }
+
+        void add(const std::string &name, const Tensor4D &tensor, DType dtype = DType::F32) {
+            add(name, PackedTensor(tensor, dtype));
+        }
+
+        void write(const std::string &path) const {
+            std::vector<weight_file::Entry> table(entries.size());
+            uint64_t offset = weight_file::align(sizeof(weight_file::Header) + table.size() * sizeof(weight_file::Entry));
+            for (size_t i = 0; i < entries.size(); ++i) {
+                const auto &[name, tensor] = entries[i];
+                weight_file::Entry &entry = table[i];
+                std::memset(&entry, 0, sizeof(entry));
+                std::memcpy(entry.name, name.data(), name.size());
+                entry.dtype = static_cast<uint8_t>(tensor.dtype());
+                for (size_t d = 0; d < 4; ++d) {
+                    entry.dims[d] = tensor.shape()[d];
+                }
+                entry.offset = offset;
+                offset = weight_file::align(offset + tensor.nbytes());
+            }
+
+            weight_file::Header header{};
+            std::memcpy(header.magic, weight_file::MAGIC, sizeof(header.magic));
+            header.version = weight_file::VERSION;
+            header.count = static_cast<uint32_t>(entries.size());
+            header.file_size = offset;
+
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                throw std::runtime_error("Cannot write weight file: " + path);
+            }
+            out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char *>(table.data()),
+                      static_cast<std::streamsize>(table.size() * sizeof(weight_file::Entry)));
+            uint64_t written = sizeof(header) + table.size() * sizeof(weight_file::Entry);
+            const char zeros[weight_file::ALIGNMENT] = {};
+            for (size_t i = 0; i < entries.size(); ++i) {
+                out.write(zeros, static_cast<std::streamsize>(table[i].offset - written));
+                const PackedTensor &tensor = entries[i].second;
+                out.write(static_cast<const char *>(tensor.data()), static_cast<std::streamsize>(tensor.nbytes()));
+                written = table[i].offset + tensor.nbytes();
+            }
+            out.write(zeros, static_cast<std::streamsize>(offset - written));
+            if (!out) {
+                throw std::runtime_error("Failed writing weight file: " + path);
+            }
+        }
+    };
+
+    // Points every parameter of the model at the matching tensor in the file. Shapes must match;
+    // weights keep the dtype they were stored with.
+    template<typename Model>
+    void load_weights(Model &model, const WeightFile &file) {
+        model.visit_parameters("", [&](const std::string &name, PackedTensor &tensor) {
+            const PackedTensor &stored = file.get(name);
+            if (stored.shape() != tensor.shape()) {
+                throw std::invalid_argument("Weight file shape does not match the model for " + name);
+            }
+            tensor = stored;
+        });
+    }
+
+    template<typename Model>
+    void save_weights(Model &model, const std::string &path) {
+        WeightFileWriter writer;
+        model.visit_parameters("", [&](const std::string &name, PackedTensor &tensor) {
+            writer.add(name, tensor);
+        });
+        writer.write(path);
+    }
+
+} // namespace nnm
@@ -1,4 +1,99 @@
+// Minimal nnm inference driver; it needs nothing beyond the headers in this directory.
+//
+//   CNN <weights.nnmw> [board] [--dtype f32|f16|bf16] [--int8]
+//
+// board is nine characters from {x, o, .} in row-major order; the side to move is x when both
+// players have the same number of stones. With --int8 the model is calibrated on positions from
+// random play before evaluating, and the accuracy cost is printed.
 
-int main() {
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "TicTacToeModel.h"
+#include "Quantization.h"
 
-}
\ No newline at end of file
+namespace {
+
+    // Same planes as TicTacToe::getEncodedState: side to move, opponent, empty.
+    nnm::Tensor4D encodeBoard(const std::string &board) {
+        if (board.size() != 9 || board.find_first_not_of("xo.") != std::string::npos) {
+            throw std::invalid_argument("Board must be nine characters from {x, o, .}: " + board);
+        }
+        long xs = std::count(board.begin(), board.end(), 'x');
+        long os = std::count(board.begin(), board.end(), 'o');
+        char to_move = xs == os ? 'x' : 'o';
+
+        nnm::Tensor4D tensor(1, 3, 3, 3);
+        for (size_t i = 0; i < 9; ++i) {
+            size_t plane = board[i] == '.' ? 2 : board[i] == to_move ? 0 : 1;
+            tensor(0, plane, i / 3, i % 3) = 1.0f;
+        }
+        return tensor;
+    }
+
+    std::vector<nnm::Tensor4D> randomPositions(size_t count) {
+        std::mt19937 gen(7);
+        std::vector<nnm::Tensor4D> positions;
+        while (positions.size() < count) {
+            std::string board(9, '.');
+            std::vector<size_t> order = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+            std::shuffle(order.begin(), order.end(), gen);
+            for (size_t ply = 0; ply < 9 && positions.size() < count; ++ply) {
+                positions.push_back(encodeBoard(board));
+                board[order[ply]] = ply % 2 == 0 ? 'x' : 'o';
+            }
+        }
+        return positions;
+    }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<std::string> positional;
+    nnm::DType dtype = nnm::DType::F32;
+    bool int8 = false;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--dtype" && i + 1 < argc) {
+                dtype = nnm::dtype_from_name(argv[++i]);
+            } else if (arg == "--int8") {
+                int8 = true;
+            } else {
+                positional.push_back(arg);
+            }
+        }
+        if (positional.empty() || positional.size() > 2) {
+            std::cerr << "usage: CNN <weights.nnmw> [board] [--dtype f32|f16|bf16] [--int8]" << std::endl;
+            return 2;
+        }
+
+        nnm::TicTacToeModel model(positional[0]);
+        model.convert_weights(dtype);
+        if (int8) {
+            nnm::quant::QuantizationReport report = nnm::quant::quantize_model(model, randomPositions(512));
+            std::cout << "int8: mean policy error " << report.mean_policy_error << ", max value error "
+                      << report.max_value_error << ", best move agreement " << report.policy_agreement << std::endl;
+        }
+
+        std::string board = positional.size() == 2 ? positional[1] : std::string(9, '.');
+        auto [policy, value] = model.forward(encodeBoard(board));
+
+        std::cout << std::fixed << std::setprecision(3);
+        for (size_t row = 0; row < 3; ++row) {
+            for (size_t col = 0; col < 3; ++col) {
+                std::cout << board[row * 3 + col] << ' ' << policy(0, row * 3 + col, 0, 0) << "  ";
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "value " << value(0, 0, 0, 0) << std::endl;
+        return 0;
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <random>
+#include "Tensor4D.h"
+
+namespace nnm {
+
+    // A tensor of values drawn uniformly from [lo, hi); the same seed always gives the same tensor.
+    inline Tensor4D random_tensor(size_t n, size_t c, size_t h, size_t w, unsigned seed = 7,
+                                  float lo = -1.0f, float hi = 1.0f) {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<float> dis(lo, hi);
+        Tensor4D tensor(n, c, h, w);
+        for (float &v: tensor.getData()) {
+            v = dis(gen);
+        }
+        return tensor;
+    }
+
+} // namespace nnm
@@ -13,5 +13,42 @@ namespace nnm {
 
     };
 
-    // TODO : Test the forward method
+    TEST_F(BatchNorm2dTest, ForwardUsesRunningStatistics) {
+        BatchNorm2d bn(2);
+        bn.set_parameters(Tensor4D(1, 2, 1, 1, {2.0f, 0.5f}), Tensor4D(1, 2, 1, 1, {0.1f, -1.0f}),
+                          Tensor4D(1, 2, 1, 1, {1.0f, -2.0f}), Tensor4D(1, 2, 1, 1, {4.0f, 0.25f}));
+        Tensor4D x(2, 2, 2, 3);
+        for (size_t i = 0; i < x.getData().size(); ++i) {
+            x.getData()[i] = static_cast<float>(i) * 0.3f - 2.0f;
+        }
+
+        Tensor4D y = bn.forward(x);
+
+        const float gamma[] = {2.0f, 0.5f}, beta[] = {0.1f, -1.0f}, mean[] = {1.0f, -2.0f}, var[] = {4.0f, 0.25f};
+        for (size_t n = 0; n < 2; ++n) {
+            for (size_t c = 0; c < 2; ++c) {
+                for (size_t h = 0; h < 2; ++h) {
+                    for (size_t w = 0; w < 3; ++w) {
+                        float expected = (x(n, c, h, w) - mean[c]) / std::sqrt(var[c] + 1e-5f) * gamma[c] + beta[c];
+                        EXPECT_NEAR(y(n, c, h, w), expected, epsilon);
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_F(BatchNorm2dTest, FoldedParametersPassInputThrough) {
+        // What the exporter writes after folding a batch norm into the preceding convolution.
+        BatchNorm2d bn(3);
+        bn.set_parameters(Tensor4D(1, 3, 1, 1, 1.0f), Tensor4D(1, 3, 1, 1, 0.0f),
+                          Tensor4D(1, 3, 1, 1, 0.0f), Tensor4D(1, 3, 1, 1, static_cast<float>(1.0 - 1e-5)));
+        Tensor4D x(1, 3, 2, 2, 0.7f);
+        Tensor4D reference = x;
+        const float *buffer = x.getData().data();
+
+        Tensor4D y = bn.forward(std::move(x));
+
+        EXPECT_EQ(y.getData().data(), buffer);
+        EXPECT_TRUE(y == reference);
+    }
 } // namespace nnm
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include "ElementWise.h"
+#include "Tensor4D.h"
+#include "Matrix.h"
+#include "RandomTensor.h"
+
+namespace nnm {
+
+    class ElementWiseTest : public ::testing::Test {};
+
+    TEST_F(ElementWiseTest, BiasBroadcastOverChannels) {
+        Tensor4D x = random_tensor(2, 3, 3, 3);
+        Tensor4D bias(1, 3, 1, 1);
+        bias(0, 0, 0, 0) = 1.0f;
+        bias(0, 1, 0, 0) = -2.0f;
+        bias(0, 2, 0, 0) = 0.5f;
+
+        Tensor4D out = x + bias;
+        for (size_t n = 0; n < 2; ++n) {
+            for (size_t c = 0; c < 3; ++c) {
+                for (size_t h = 0; h < 3; ++h) {
+                    for (size_t w = 0; w < 3; ++w) {
+                        EXPECT_FLOAT_EQ(out(n, c, h, w), x(n, c, h, w) + bias(0, c, 0, 0));
+                    }
+                }
+            }
+        }
+
+        x.add_(bias);
+        EXPECT_TRUE(x == out);
+    }
+
+    TEST_F(ElementWiseTest, BroadcastBothSides) {
+        Tensor4D column = random_tensor(1, 1, 5, 1);
+        Tensor4D row = random_tensor(1, 1, 1, 7);
+
+        Tensor4D out = column.elementWiseMul(row);
+        ASSERT_EQ(out.getHeight(), 5);
+        ASSERT_EQ(out.getWidth(), 7);
+        for (size_t h = 0; h < 5; ++h) {
+            for (size_t w = 0; w < 7; ++w) {
+                EXPECT_FLOAT_EQ(out(0, 0, h, w), column(0, 0, h, 0) * row(0, 0, 0, w));
+            }
+        }
+
+        // The left operand of an in-place op must already have the result shape.
+        EXPECT_THROW(column.add_(row), std::invalid_argument);
+        EXPECT_THROW(column + random_tensor(1, 1, 4, 1), std::invalid_argument);
+    }
+
+    TEST_F(ElementWiseTest, TernaryMulAddWithBroadcast) {
+        Tensor4D x = random_tensor(4, 8, 6, 6);
+        Tensor4D scale = random_tensor(1, 8, 1, 1);
+        Tensor4D shift = random_tensor(1, 8, 1, 1);
+        Tensor4D out(x.shape());
+
+        elementwise::ternary(out.getData().data(), out.shape(),
+                             x.getData().data(), x.shape(),
+                             scale.getData().data(), scale.shape(),
+                             shift.getData().data(), shift.shape(), elementwise::MulAdd{});
+
+        for (size_t n = 0; n < 4; ++n) {
+            for (size_t c = 0; c < 8; ++c) {
+                for (size_t h = 0; h < 6; ++h) {
+                    for (size_t w = 0; w < 6; ++w) {
+                        EXPECT_NEAR(out(n, c, h, w), x(n, c, h, w) * scale(0, c, 0, 0) + shift(0, c, 0, 0), 1e-5f);
+                    }
+                }
+            }
+        }
+    }
+
+    TEST_F(ElementWiseTest, LargeTensorsMatchScalarReference) {
+        // Large enough to take the OpenMP path, with a length that leaves a scalar tail.
+        Tensor4D a = random_tensor(3, 17, 31, 29);
+        Tensor4D b = random_tensor(3, 17, 31, 29);
+        ASSERT_GT(a.getData().size(), elementwise::PARALLEL_THRESHOLD);
+
+        Tensor4D sum = a + b;
+        Tensor4D clamped = a;
+        clamped.clamp_(-0.5f, 0.25f);
+        for (size_t i = 0; i < a.getData().size(); ++i) {
+            EXPECT_FLOAT_EQ(sum.getData()[i], a.getData()[i] + b.getData()[i]);
+            EXPECT_FLOAT_EQ(clamped.getData()[i], std::min(std::max(a.getData()[i], -0.5f), 0.25f));
+        }
+
+        Tensor4D filled(3, 17, 31, 29);
+        filled.fill(1.25f);
+        EXPECT_FLOAT_EQ(filled.sum() / static_cast<float>(filled.getData().size()), 1.25f);
+    }
+
+    TEST_F(ElementWiseTest, MatrixRoutesThroughEngine) {
+        Matrix a(3, 11, 2.0f);
+        Matrix b(3, 11, 0.5f);
+        Matrix diff = a - b;
+        Matrix prod = a.elementWiseMul(b);
+        for (size_t i = 0; i < 3; ++i) {
+            for (size_t j = 0; j < 11; ++j) {
+                EXPECT_FLOAT_EQ(diff(i, j), 1.5f);
+                EXPECT_FLOAT_EQ(prod(i, j), 1.0f);
+            }
+        }
+    }
+
+} // namespace nnm
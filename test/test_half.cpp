@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "Half.h"
+#include "PackedTensor.h"
+#include "Gemm.h"
+#include "ConvolutionalLayer.h"
+#include "LinearLayer.h"
+#include "ResNet.h"
+#include "RandomTensor.h"
+#include <cmath>
+
+namespace nnm {
+
+    class HalfTest : public ::testing::Test {
+    protected:
+        static float max_abs_diff(const Tensor4D &a, const Tensor4D &b) {
+            float worst = 0.0f;
+            for (size_t i = 0; i < a.getData().size(); ++i) {
+                worst = std::max(worst, std::abs(a.getData()[i] - b.getData()[i]));
+            }
+            return worst;
+        }
+    };
+
+    TEST_F(HalfTest, ScalarConversions) {
+        EXPECT_EQ(half::float_to_f16(1.0f), 0x3c00);
+        EXPECT_EQ(half::float_to_f16(-2.0f), 0xc000);
+        EXPECT_FLOAT_EQ(half::f16_to_float(0x3555), 0.33325195f);
+        EXPECT_TRUE(std::isinf(half::f16_to_float(half::float_to_f16(1e6f))));
+
+        EXPECT_EQ(half::float_to_bf16(1.0f), 0x3f80);
+        // 1 + 2^-8 is exactly halfway between two bf16 values and rounds to the even one.
+        EXPECT_EQ(half::float_to_bf16(1.00390625f), 0x3f80);
+        EXPECT_EQ(half::float_to_bf16(1.01171875f), 0x3f82);
+        EXPECT_TRUE(std::isnan(half::bf16_to_float(half::float_to_bf16(NAN))));
+    }
+
+    TEST_F(HalfTest, PackedTensorRoundTrip) {
+        Tensor4D x = random_tensor(2, 3, 5, 7);
+        for (DType dtype: {DType::F32, DType::F16, DType::BF16}) {
+            PackedTensor packed(x, dtype);
+            EXPECT_EQ(packed.nbytes(), x.getData().size() * dtype_size(dtype));
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(packed.data()) % 64, 0u);
+            float tolerance = dtype == DType::F32 ? 0.0f : dtype == DType::F16 ? 1e-3f : 1e-2f;
+            EXPECT_LE(max_abs_diff(packed.toTensor(), x), tolerance) << dtype_name(dtype);
+        }
+        EXPECT_THROW((void) PackedTensor(x, DType::F16).data_as<DType::F32>(), std::invalid_argument);
+    }
+
+    TEST_F(HalfTest, GemmMatchesReferenceForEveryDtype) {
+        const size_t M = 7, N = 11, K = 37;
+        Tensor4D a = random_tensor(1, 1, M, K, 5);
+        Tensor4D w = random_tensor(1, 1, N, K, 6);
+        Tensor4D bias = random_tensor(1, 1, 1, N, 7);
+
+        for (DType dtype: {DType::F32, DType::F16, DType::BF16}) {
+            PackedTensor packed(w, dtype);
+            Tensor4D expanded = packed.toTensor();
+            std::vector<float> c(M * N);
+            gemm::gemm_nt(a.getData().data(), M, K, packed, N, bias.getData().data(), c.data(), N, 1);
+            for (size_t m = 0; m < M; ++m) {
+                for (size_t n = 0; n < N; ++n) {
+                    double expected = bias.getData()[n];
+                    for (size_t k = 0; k < K; ++k) {
+                        expected += a.getData()[m * K + k] * expanded.getData()[n * K + k];
+                    }
+                    EXPECT_NEAR(c[m * N + n], expected, 1e-4) << dtype_name(dtype) << " at " << m << "," << n;
+                }
+            }
+        }
+    }
+
+    TEST_F(HalfTest, HalfWeightsStayCloseToFloat) {
+        ConvolutionalLayer conv(4, 6, 3, 1, 1);
+        LinearLayer linear(6 * 5 * 5, 9);
+        Tensor4D x = random_tensor(2, 4, 5, 5, 9);
+
+        Tensor4D reference = linear.forward(conv.forward(x));
+        size_t float_bytes = conv.weight_bytes() + linear.weight_bytes();
+
+        conv.convert_weights(DType::F16);
+        linear.convert_weights(DType::F16);
+        EXPECT_LT(conv.weight_bytes() + linear.weight_bytes(), float_bytes * 6 / 10);
+        EXPECT_LT(max_abs_diff(linear.forward(conv.forward(x)), reference), 5e-3f);
+
+        conv.convert_weights(DType::BF16);
+        linear.convert_weights(DType::BF16);
+        EXPECT_LT(max_abs_diff(linear.forward(conv.forward(x)), reference), 5e-2f);
+    }
+
+    TEST_F(HalfTest, LinearTreatsFlattenRowsAsBatch) {
+        LinearLayer linear(6, 4);
+        Tensor4D batch = random_tensor(3, 6, 1, 1, 11);
+        Tensor4D flattened(1, 3, 6, 1, batch.getData());
+
+        Tensor4D expected = linear.forward(batch);
+        Tensor4D result = linear.forward(flattened);
+        ASSERT_EQ(result.getBatchSize(), 3);
+        ASSERT_EQ(result.getChannels(), 4);
+        EXPECT_TRUE(result == expected);
+    }
+
+    TEST_F(HalfTest, ResNetConversionHalvesWeightStorage) {
+        ResNet model(1, 8, 9, 3, 3);
+        Tensor4D x = random_tensor(1, 3, 3, 3, 13);
+        auto [policy, value] = model.forward(x);
+        size_t float_bytes = model.weight_bytes();
+
+        model.convert_weights(DType::F16);
+        auto [half_policy, half_value] = model.forward(x);
+
+        EXPECT_LT(model.weight_bytes(), float_bytes * 6 / 10);
+        EXPECT_LT(max_abs_diff(half_policy, policy), 1e-2f);
+        EXPECT_LT(max_abs_diff(half_value, value), 1e-2f);
+    }
+
+} // namespace nnm
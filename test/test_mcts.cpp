@@ -0,0 +1,1057 @@
+#include <gtest/gtest.h>
+#include "BatchScheduler.h"
+#include "MCTSLearn.h"
+#include "PrecomputedEvaluator.h"
+#include "Solver.h"
+#include "UltimateTicTacToe.h"
+#include <cmath>
+#include <numeric>
+#include <random>
+
+namespace {
+
+    nnm::TicTacToeModel &shippedModel() {
+        static nnm::TicTacToeModel model(std::string(NNM_MODELS_DIR) + "/tictactoe.nnmw");
+        return model;
+    }
+
+    // Uniform priors and a neutral value for any game, counting how often the search asks.
+    template<Game G>
+    class UniformEvaluator : public Evaluator<G> {
+    public:
+        std::atomic<size_t> calls = 0;
+        std::atomic<size_t> largest_batch = 0;
+
+        // Parallel searches call from several workers at once.
+        void record(size_t batch) {
+            calls += batch;
+            size_t largest = largest_batch.load();
+            while (largest < batch && !largest_batch.compare_exchange_weak(largest, batch)) {}
+        }
+
+        Evaluation evaluate(const G &) override {
+            record(1);
+            return {std::vector<float>(G::ACTION_SIZE, 1.0f / G::ACTION_SIZE), 0.0f};
+        }
+
+        std::vector<Evaluation> evaluateBatch(const std::vector<G> &games) override {
+            record(games.size());
+            return std::vector<Evaluation>(games.size(),
+                                           {std::vector<float>(G::ACTION_SIZE, 1.0f / G::ACTION_SIZE), 0.0f});
+        }
+    };
+
+    TicTacToe play(std::initializer_list<uint8_t> moves) {
+        TicTacToe game;
+        for (uint8_t move: moves) {
+            game.makeMove(move);
+        }
+        return game;
+    }
+
+    BatchScheduler<TicTacToe>::Task searchJob(BatchScheduler<TicTacToe> &scheduler, const MCTSLearn<TicTacToe> &mcts,
+                                              TicTacToe game, std::vector<float> &result) {
+        SearchTree<TicTacToe> tree(game);
+        MCTSLearn<TicTacToe>::Search search(mcts, tree, scheduler.cache(), 200, &scheduler.backend());
+        while (!search.finished()) {
+            search.complete(co_await scheduler.evaluate(search.collect()));
+        }
+        result = MCTSLearn<TicTacToe>::visitDistribution(*tree.root());
+    }
+
+    BatchScheduler<TicTacToe>::Task failingJob(BatchScheduler<TicTacToe> &scheduler) {
+        std::vector<TicTacToe> positions = {TicTacToe()};
+        co_await scheduler.evaluate(positions);
+        throw std::runtime_error("job failed");
+    }
+
+    TEST(MCTSTest, NnmEvaluatorMatchesModel) {
+        NnmEvaluator<nnm::TicTacToeModel> evaluator(shippedModel());
+        TicTacToe game = play({4, 0});
+
+        Evaluation evaluation = evaluator.evaluate(game);
+        auto [policy, value] = shippedModel().forward(game.getEncodedState());
+        ASSERT_EQ(evaluation.policy.size(), 9u);
+        EXPECT_EQ(evaluation.policy, policy.getData());
+        EXPECT_FLOAT_EQ(evaluation.value, value(0, 0, 0, 0));
+    }
+
+    TEST(MCTSTest, NnmEvaluatorNormalizesResNetLogits) {
+        nnm::ResNet model(2, 8, 9, 3, 3);
+        NnmEvaluator<nnm::ResNet> evaluator(model);
+
+        Evaluation evaluation = evaluator.evaluate(TicTacToe());
+        ASSERT_EQ(evaluation.policy.size(), 9u);
+        EXPECT_NEAR(std::accumulate(evaluation.policy.begin(), evaluation.policy.end(), 0.0f), 1.0f, 1e-5);
+        EXPECT_GE(evaluation.value, -1.0f);
+        EXPECT_LE(evaluation.value, 1.0f);
+    }
+
+    TEST(MCTSTest, NnmBatchMatchesSinglePositions) {
+        NnmEvaluator<nnm::TicTacToeModel> evaluator(shippedModel());
+        std::vector<TicTacToe> games = {TicTacToe(), play({4}), play({4, 0}), play({0, 3, 1, 4}), play({8, 6, 2})};
+
+        std::vector<Evaluation> batch = evaluator.evaluateBatch(games);
+        ASSERT_EQ(batch.size(), games.size());
+        for (size_t i = 0; i < games.size(); ++i) {
+            Evaluation single = evaluator.evaluate(games[i]);
+            ASSERT_EQ(batch[i].policy.size(), 9u);
+            for (size_t a = 0; a < 9; ++a) {
+                EXPECT_NEAR(batch[i].policy[a], single.policy[a], 1e-6) << i << "," << a;
+            }
+            EXPECT_NEAR(batch[i].value, single.value, 1e-6) << i;
+        }
+
+        nnm::ResNet resnet(1, 8, 9, 3, 3);
+        NnmEvaluator<nnm::ResNet> resnet_evaluator(resnet);
+        std::vector<Evaluation> resnet_batch = resnet_evaluator.evaluateBatch(games);
+        for (size_t i = 0; i < games.size(); ++i) {
+            EXPECT_NEAR(resnet_batch[i].value, resnet_evaluator.evaluate(games[i]).value, 1e-5) << i;
+        }
+    }
+
+    TEST(MCTSTest, SearchOnNativeModelFindsWin) {
+        NnmEvaluator<nnm::TicTacToeModel> evaluator(shippedModel());
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        // x holds 0 and 1, o holds 3 and 4; x wins at 2.
+        TicTacToe game = play({0, 3, 1, 4});
+
+        std::vector<float> probs = mcts.search(game, evaluator, 200);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        for (uint8_t taken: {0, 1, 3, 4}) {
+            EXPECT_EQ(probs[taken], 0.0f);
+        }
+        EXPECT_EQ(std::max_element(probs.begin(), probs.end()) - probs.begin(), 2);
+
+        mcts.setBatchSize(8);
+        probs = mcts.search(game, evaluator, 200);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        EXPECT_EQ(std::max_element(probs.begin(), probs.end()) - probs.begin(), 2);
+    }
+
+    TEST(MCTSTest, OneEvaluationPerSimulation) {
+        UniformEvaluator<TicTacToe> evaluator;
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+
+        mcts.search(TicTacToe(), evaluator, 100);
+        // Simulations that end on a finished game need no evaluation at all.
+        EXPECT_GT(evaluator.calls.load(), 0u);
+        EXPECT_LE(evaluator.calls.load(), 100u);
+
+        evaluator.calls = 0;
+        mcts.search(play({0, 4, 8, 2, 6}), evaluator, 50);
+        EXPECT_LE(evaluator.calls.load(), 50u);
+    }
+
+    TEST(MCTSTest, BatchedSearchUsesVirtualLoss) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        mcts.setBatchSize(16);
+        // Symmetric leaves would share one batch entry.
+        mcts.setSymmetries(false);
+        UniformEvaluator<TicTacToe> evaluator;
+
+        std::vector<float> probs = mcts.search(TicTacToe(), evaluator, 400);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        EXPECT_LE(evaluator.calls.load(), 400u);
+        // Without virtual loss every descent of a batch would reach the same leaf.
+        EXPECT_EQ(evaluator.largest_batch, 16u);
+        EXPECT_THROW(mcts.setBatchSize(0), std::invalid_argument);
+    }
+
+    TEST(MCTSTest, AdaptiveBatchGrowsUpToLimit) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        mcts.setBatchSize(8, true);
+        UniformEvaluator<TicTacToe> evaluator;
+
+        mcts.search(TicTacToe(), evaluator, 300);
+        EXPECT_GT(evaluator.largest_batch, 1u);
+        EXPECT_LE(evaluator.largest_batch, 8u);
+    }
+
+    TEST(MCTSTest, TreeParallelSearchSharesOneTree) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        UniformEvaluator<TicTacToe> counting;
+        std::vector<float> probs = mcts.searchParallel(TicTacToe(), counting, 500, 4);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        // Every leaf is expanded by exactly one worker.
+        EXPECT_LE(counting.calls.load(), 500u);
+
+        NnmEvaluator<nnm::TicTacToeModel> evaluator(shippedModel());
+        probs = mcts.searchParallel(play({0, 3, 1, 4}), evaluator, 200, 4);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        EXPECT_EQ(std::max_element(probs.begin(), probs.end()) - probs.begin(), 2);
+    }
+
+    // Uniform priors until the budget of successful evaluations runs out, then throws.
+    class FailingEvaluator : public Evaluator<TicTacToe> {
+    public:
+        std::atomic<int> budget;
+
+        explicit FailingEvaluator(int budget) : budget(budget) {}
+
+        Evaluation evaluate(const TicTacToe &) override {
+            if (budget.fetch_sub(1) <= 0) {
+                throw std::runtime_error("evaluation failed");
+            }
+            return {std::vector<float>(9, 1.0f / 9), 0.0f};
+        }
+    };
+
+    // No node of the graph is left claimed, and no edge holds a virtual loss: an expanded node has
+    // one more visit than its edges, for the simulation that expanded it.
+    void expectNoPendingWork(const Node<TicTacToe> *node) {
+        ASSERT_NE(node->_expansion.load(), Expansion::pending);
+        if (!node->isExpanded()) {
+            return;
+        }
+        int edge_visits = 0;
+        for (int i = 0; i < node->_nMoves; ++i) {
+            edge_visits += node->_edges.visits[i].load();
+            if (const Node<TicTacToe> *child = node->_edges.children[i].load()) {
+                expectNoPendingWork(child);
+            }
+        }
+        EXPECT_EQ(edge_visits, node->visits() - 1);
+    }
+
+    TEST(MCTSTest, TreeParallelSearchRethrowsEvaluatorErrors) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        mcts.setTranspositions(false);
+        SearchTree<TicTacToe> tree(TicTacToe{});
+
+        FailingEvaluator failing(0);
+        EXPECT_THROW(mcts.searchParallel(tree, failing, 100, 4), std::runtime_error);
+        EXPECT_EQ(tree.root()->_expansion.load(), Expansion::none);
+        EXPECT_EQ(tree.root()->visits(), 0);
+
+        FailingEvaluator later(20);
+        EXPECT_THROW(mcts.searchParallel(tree, later, 500, 4), std::runtime_error);
+        expectNoPendingWork(tree.root());
+
+        // The tree stays usable: the leaves that failed are expanded by the next search.
+        UniformEvaluator<TicTacToe> counting;
+        std::vector<float> probs = mcts.searchParallel(tree, counting, 100, 4);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        expectNoPendingWork(tree.root());
+    }
+
+    TEST(MCTSTest, NodeArenaReusesChunksAfterReset) {
+        NodeArena arena;
+        void *first = arena.allocateBytes(100);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(first) % NodeArena::ALIGNMENT, 0u);
+        EXPECT_EQ(static_cast<std::byte *>(arena.allocateBytes(1)) - static_cast<std::byte *>(first), 128);
+        arena.allocateBytes(NodeArena::CHUNK_BYTES / 2);
+        EXPECT_EQ(arena.chunkCount(), 1u);
+        arena.allocateBytes(NodeArena::CHUNK_BYTES / 2);
+        EXPECT_EQ(arena.chunkCount(), 2u);
+
+        arena.reset();
+        EXPECT_EQ(arena.allocateBytes(100), first);
+        EXPECT_EQ(arena.chunkCount(), 2u);
+        EXPECT_THROW(arena.allocateBytes(NodeArena::CHUNK_BYTES + 1), std::invalid_argument);
+    }
+
+    TEST(MCTSTest, EdgesArePaddedAndChildrenCreatedOnFirstVisit) {
+        NodeArena arena;
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        Node<TicTacToe> root(play({4}));
+        mcts.expand(&root, std::vector<float>(9, 1.0f / 9).data(), arena);
+
+        ASSERT_EQ(root._nMoves, 8);
+        for (size_t i = 0; i < Edges<TicTacToe>::padded(root._nMoves); ++i) {
+            EXPECT_EQ(root._edges.children[i].load(), nullptr);
+            EXPECT_EQ(root._edges.visits[i].load(), 0);
+        }
+        EXPECT_EQ(root._edges.moves[4], 5);
+        EXPECT_FLOAT_EQ(root._edges.priors[0], 1.0f / 8);
+
+        Node<TicTacToe> *child = root.child(4, arena);
+        EXPECT_EQ(root.child(4, arena), child);
+        EXPECT_EQ(child->_game.getKey(), play({4, 5}).getKey());
+        EXPECT_EQ(child->_nMoves, 7);
+        Path<TicTacToe> path;
+        path.nodes = {&root, child};
+        path.edges[0] = 4;
+        path.length = 2;
+        backpropagate(path, 1.0f);
+        EXPECT_EQ(root._edges.visits[4].load(), 1);
+        EXPECT_FLOAT_EQ(root._edges.values[4].load(), 1.0f);
+        EXPECT_EQ(child->visits(), 1);
+        EXPECT_FLOAT_EQ(child->_value.load(), 1.0f);
+        EXPECT_EQ(root._nSims.load(), 1);
+        EXPECT_FLOAT_EQ(root._value.load(), -1.0f);
+    }
+
+    TEST(MCTSTest, SearchesReuseTheThreadArena) {
+        // Without noise and with uniform priors every search builds the same tree.
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        UniformEvaluator<TicTacToe> evaluator;
+        mcts.search(TicTacToe(), evaluator, 3000);
+        size_t chunks = MCTSLearn<TicTacToe>::threadTree().arena().chunkCount();
+        EXPECT_GT(chunks, 1u);
+        for (int i = 0; i < 3; ++i) {
+            mcts.search(TicTacToe(), evaluator, 3000);
+        }
+        EXPECT_EQ(MCTSLearn<TicTacToe>::threadTree().arena().chunkCount(), chunks);
+    }
+
+    TEST(MCTSTest, VectorizedSelectionMatchesScalarPuct) {
+        NodeArena arena;
+        std::mt19937 gen(11);
+        std::uniform_real_distribution<float> prior(0.0f, 1.0f);
+        std::uniform_int_distribution<int> visits(0, 40);
+
+        // Ultimate Tic-Tac-Toe sized edge lists as well as short ones with padding.
+        for (uint8_t count: {1, 5, 9, 17, 81}) {
+            Node<TicTacToe> node(TicTacToe{});
+            node._nMoves = count;
+            node._edges = Edges<TicTacToe>::allocate(arena, count);
+            node._nSims = 0;
+            for (uint8_t i = 0; i < count; ++i) {
+                int n = visits(gen);
+                node._edges.priors[i] = prior(gen);
+                node._edges.visits[i] = n;
+                node._edges.values[i] = n * (2.0f * prior(gen) - 1.0f);
+                node._nSims += n;
+            }
+
+            int expected = 0;
+            float best = -std::numeric_limits<float>::infinity();
+            for (int i = 0; i < count; ++i) {
+                float n = node._edges.visits[i];
+                float q = n > 0 ? node._edges.values[i] / n : 0.0f;
+                float score = q + C * std::sqrt(static_cast<float>(node._nSims)) * node._edges.priors[i] / (n + 1);
+                if (score > best) {
+                    best = score;
+                    expected = i;
+                }
+            }
+            EXPECT_EQ(selectUcb(&node), expected) << static_cast<int>(count);
+        }
+    }
+
+    TEST(MCTSTest, AdvancedTreeKeepsTheSearchedSubtree) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        UniformEvaluator<TicTacToe> evaluator;
+        SearchTree<TicTacToe> tree(TicTacToe{});
+        mcts.search(tree, evaluator, 200);
+
+        const Edges<TicTacToe> &edges = tree.root()->_edges;
+        int kept = edges.visits[std::find(edges.moves, edges.moves + tree.root()->_nMoves, 4) - edges.moves];
+        tree.advance(4);
+        EXPECT_EQ(tree.root()->visits(), kept);
+        EXPECT_GT(kept, 0);
+
+        evaluator.calls = 0;
+        std::vector<float> probs = mcts.search(tree, evaluator, 10);
+        EXPECT_LE(evaluator.calls, 10u);
+        EXPECT_EQ(tree.root()->visits(), kept + 10);
+        EXPECT_EQ(probs[4], 0.0f);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+
+        EXPECT_THROW(tree.advance(4), std::invalid_argument);
+    }
+
+    TEST(MCTSTest, AdvancingToAnUnvisitedMoveStartsOver) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        UniformEvaluator<TicTacToe> evaluator;
+        SearchTree<TicTacToe> tree(TicTacToe{});
+
+        tree.advance(0);
+        EXPECT_EQ(tree.root()->visits(), 0);
+        mcts.search(tree, evaluator, 2);
+        tree.advance(8);
+        EXPECT_THROW(tree.advance(0), std::invalid_argument);
+        EXPECT_THROW(tree.advance(9), std::invalid_argument);
+        tree.advance(4);
+        EXPECT_EQ(tree.root()->visits(), 0);
+        EXPECT_EQ(tree.game().getCurrentPlayer(), Player::o);
+        EXPECT_EQ(tree.root()->_nMoves, 6);
+    }
+
+    TEST(MCTSTest, TranspositionsShareNodesAndEvaluations) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        UniformEvaluator<TicTacToe> evaluator;
+
+        SearchTree<TicTacToe> tree(TicTacToe{});
+        mcts.setTranspositions(false);
+        mcts.search(tree, evaluator, 10000);
+        size_t tree_calls = evaluator.calls;
+        // Without transpositions the table is never grown past its first allocation.
+        EXPECT_LE(tree.table().slotCount(), 64u);
+
+        evaluator.calls = 0;
+        tree.reset(TicTacToe{});
+        mcts.setTranspositions(true);
+        mcts.search(tree, evaluator, 10000);
+        EXPECT_LT(evaluator.calls * 2, tree_calls);
+        EXPECT_EQ(tree.root()->visits(), 10000);
+        // Tic-tac-toe has 5478 positions; a graph never holds one twice.
+        EXPECT_LE(tree.table().size(), 5478u);
+
+        // x at 0 and 4, o at 8: two move orders, one node.
+        auto walk = [&tree](std::initializer_list<uint8_t> edges) {
+            Node<TicTacToe> *node = tree.root();
+            for (uint8_t edge: edges) {
+                EXPECT_TRUE(node->isExpanded());
+                node = node->child(edge, tree.arena(), &tree.table());
+            }
+            return node;
+        };
+        Node<TicTacToe> *via_first = walk({0, 7, 3});
+        Node<TicTacToe> *via_second = walk({4, 7, 0});
+        EXPECT_EQ(via_first, via_second);
+        EXPECT_EQ(via_first->_game.getKey(), play({0, 8, 4}).getKey());
+
+        // Advancing keeps the sharing: o at 2 and 8 around x at 4 still meet in one node.
+        tree.advance(0);
+        auto play_moves = [&tree](std::initializer_list<uint8_t> moves) {
+            Node<TicTacToe> *node = tree.root();
+            for (uint8_t move: moves) {
+                EXPECT_TRUE(node->isExpanded());
+                const uint8_t *found = std::find(node->_edges.moves, node->_edges.moves + node->_nMoves, move);
+                node = node->child(static_cast<uint8_t>(found - node->_edges.moves), tree.arena(), &tree.table());
+            }
+            return node;
+        };
+        EXPECT_EQ(play_moves({8, 4, 2}), play_moves({2, 4, 8}));
+        EXPECT_EQ(tree.table().find(play({0, 8, 4, 2}).getKey()), play_moves({8, 4, 2}));
+    }
+
+    TEST(MCTSTest, TranspositionTableKeepsEntriesWhenGrowing) {
+        NodeArena arena;
+        TranspositionTable<Node<TicTacToe>> table;
+        EXPECT_EQ(table.insert(1, nullptr), nullptr);
+
+        table.reserve(10);
+        std::vector<Node<TicTacToe> *> nodes;
+        for (uint8_t move = 0; move < 9; ++move) {
+            nodes.push_back(new(arena.allocate<Node<TicTacToe>>(1)) Node<TicTacToe>(play({move})));
+            EXPECT_EQ(table.insert(nodes.back()->_game.getKey(), nodes.back()), nodes.back());
+        }
+        Node<TicTacToe> *duplicate = new(arena.allocate<Node<TicTacToe>>(1)) Node<TicTacToe>(play({4}));
+        EXPECT_EQ(table.insert(duplicate->_game.getKey(), duplicate), nodes[4]);
+
+        table.reserve(1000);
+        EXPECT_EQ(table.size(), 9u);
+        for (uint8_t move = 0; move < 9; ++move) {
+            EXPECT_EQ(table.find(play({move}).getKey()), nodes[move]);
+        }
+        EXPECT_EQ(table.find(play({0, 1}).getKey()), nullptr);
+
+        table.clear();
+        EXPECT_EQ(table.find(play({4}).getKey()), nullptr);
+        EXPECT_EQ(table.size(), 0u);
+    }
+
+    TEST(MCTSTest, EvaluationCacheIsInvalidatedByGeneration) {
+        EvaluationCache<TicTacToe> cache(100);
+        EXPECT_EQ(cache.capacity(), 128u);
+        EXPECT_THROW(EvaluationCache<TicTacToe>(0), std::invalid_argument);
+
+        Evaluation evaluation{std::vector<float>(9, 0.0f), 0.5f};
+        evaluation.policy[4] = 1.0f;
+        const uint64_t key = play({0, 8}).getKey();
+        Evaluation found;
+        EXPECT_FALSE(cache.find(key, found));
+        cache.store(key, evaluation);
+        ASSERT_TRUE(cache.find(key, found));
+        EXPECT_EQ(found.policy, evaluation.policy);
+        EXPECT_FLOAT_EQ(found.value, 0.5f);
+        EXPECT_FALSE(cache.find(play({8, 0}).getKey(), found));
+        EXPECT_THROW(cache.store(key, Evaluation{std::vector<float>(3), 0.0f}), std::invalid_argument);
+
+        cache.invalidate();
+        EXPECT_FALSE(cache.find(key, found));
+        EXPECT_EQ(cache.hits(), 1u);
+        EXPECT_EQ(cache.misses(), 3u);
+        EXPECT_FLOAT_EQ(cache.hitRate(), 0.25f);
+        cache.resetCounters();
+        EXPECT_EQ(cache.hits() + cache.misses(), 0u);
+    }
+
+    TEST(MCTSTest, SearchesSkipCachedEvaluations) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        EvaluationCache<TicTacToe> cache(1 << 14);
+        UniformEvaluator<TicTacToe> evaluator;
+        evaluator.setCache(&cache);
+
+        mcts.search(TicTacToe(), evaluator, 500);
+        const size_t first = evaluator.calls;
+        const size_t lookups = cache.hits() + cache.misses();
+        EXPECT_GT(first, 0u);
+        EXPECT_EQ(cache.misses(), first);
+        cache.resetCounters();
+
+        // The same search again finds every leaf in the cache.
+        std::vector<float> cold = mcts.search(TicTacToe(), evaluator, 500);
+        EXPECT_EQ(evaluator.calls, first);
+        EXPECT_EQ(cache.misses(), 0u);
+        EXPECT_EQ(cache.hits(), lookups);
+
+        // Batched and parallel searches reach other leaves too, but find the shared ones.
+        mcts.setBatchSize(8);
+        mcts.search(TicTacToe(), evaluator, 500);
+        EXPECT_GT(cache.hits(), lookups);
+        mcts.setBatchSize(1);
+        std::vector<float> parallel = mcts.searchParallel(TicTacToe(), evaluator, 500, 4);
+        EXPECT_NEAR(std::accumulate(parallel.begin(), parallel.end(), 0.0f), 1.0f, 1e-5);
+
+        cache.invalidate();
+        evaluator.calls = 0;
+        EXPECT_EQ(mcts.search(TicTacToe(), evaluator, 500), cold);
+        EXPECT_EQ(evaluator.calls, first);
+    }
+
+    TEST(MCTSTest, SymmetricPositionsShareOneCanonicalForm) {
+        for (const auto &cells: SYMMETRY_CELLS) {
+            std::array<uint8_t, 9> sorted = cells;
+            std::sort(sorted.begin(), sorted.end());
+            EXPECT_EQ(sorted, (std::array<uint8_t, 9>{0, 1, 2, 3, 4, 5, 6, 7, 8}));
+        }
+
+        for (TicTacToe game: {play({8}), play({0, 4, 7}), play({1, 2, 5, 8}), play({4, 0, 8, 2, 1})}) {
+            auto [canonical, symmetry] = game.getCanonical();
+            EXPECT_EQ(game.transformed(symmetry).getKey(), canonical.getKey());
+            for (uint8_t s = 0; s < SYMMETRY_COUNT; ++s) {
+                TicTacToe image = game.transformed(s);
+                EXPECT_EQ(image.getCanonical().first.getKey(), canonical.getKey());
+                EXPECT_LE(canonical.getKey(), image.getKey());
+                EXPECT_EQ(image.getCurrentPlayer(), game.getCurrentPlayer());
+                EXPECT_EQ(image.getGameState(), game.getGameState());
+
+                // Moves commute with the symmetry through its cell map.
+                for (uint8_t move = 0; move < 9; ++move) {
+                    if (game.getLegalMoves()[move]) {
+                        TicTacToe moved = game;
+                        moved.makeMove(move);
+                        TicTacToe image_moved = image;
+                        image_moved.makeMove(SYMMETRY_CELLS[s][move]);
+                        EXPECT_EQ(moved.transformed(s).getKey(), image_moved.getKey());
+                        EXPECT_EQ(moved.transformed(s).getGameState(), image_moved.getGameState());
+                    }
+                }
+            }
+        }
+    }
+
+    // Puts all policy on cell 1 of whatever it is shown, and remembers what that was.
+    class CellOneEvaluator : public Evaluator<TicTacToe> {
+    public:
+        std::vector<TicTacToe> seen;
+
+        Evaluation evaluate(const TicTacToe &game) override {
+            seen.push_back(game);
+            std::vector<float> policy(9, 0.0f);
+            policy[1] = 1.0f;
+            return {policy, 0.0f};
+        }
+    };
+
+    TEST(MCTSTest, SearchEvaluatesCanonicalFormsOnly) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        CellOneEvaluator evaluator;
+        TicTacToe game = play({8});
+        SearchTree<TicTacToe> tree(game);
+        mcts.search(tree, evaluator, 1);
+
+        auto [canonical, symmetry] = game.getCanonical();
+        ASSERT_EQ(evaluator.seen.size(), 1u);
+        EXPECT_EQ(evaluator.seen[0].getKey(), canonical.getKey());
+        EXPECT_NE(canonical.getKey(), game.getKey());
+        // Cell 1 of the canonical form is this move of the searched position.
+        uint8_t expected = std::find(SYMMETRY_CELLS[symmetry].begin(), SYMMETRY_CELLS[symmetry].end(), 1) -
+                           SYMMETRY_CELLS[symmetry].begin();
+        const Edges<TicTacToe> &edges = tree.root()->_edges;
+        for (uint8_t i = 0; i < tree.root()->_nMoves; ++i) {
+            EXPECT_FLOAT_EQ(edges.priors[i], edges.moves[i] == expected ? 1.0f : 0.0f) << static_cast<int>(i);
+        }
+
+        evaluator.seen.clear();
+        mcts.search(TicTacToe(), evaluator, 300);
+        for (const TicTacToe &position: evaluator.seen) {
+            EXPECT_EQ(position.getCanonical().second, 0);
+        }
+    }
+
+    TEST(MCTSTest, SymmetriesCutCachedEvaluations) {
+        UniformEvaluator<TicTacToe> evaluator;
+        EvaluationCache<TicTacToe> cache(1 << 14);
+        evaluator.setCache(&cache);
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+
+        mcts.setSymmetries(false);
+        mcts.search(TicTacToe(), evaluator, 5000);
+        size_t plain = evaluator.calls;
+
+        cache.invalidate();
+        evaluator.calls = 0;
+        mcts.setSymmetries(true);
+        mcts.search(TicTacToe(), evaluator, 5000);
+        EXPECT_LT(evaluator.calls * 3, plain);
+    }
+
+    TEST(MCTSTest, AllReachablePositionsAreEnumeratedOnce) {
+        const std::vector<TicTacToe> &positions = TicTacToe::reachablePositions();
+        EXPECT_EQ(positions.size(), TicTacToe::REACHABLE_POSITIONS);
+        std::vector<uint64_t> keys;
+        size_t canonical = 0;
+        for (const TicTacToe &game: positions) {
+            keys.push_back(game.getKey());
+            canonical += game.getCanonical().first.getKey() == game.getKey();
+        }
+        std::sort(keys.begin(), keys.end());
+        EXPECT_EQ(std::unique(keys.begin(), keys.end()), keys.end());
+        EXPECT_EQ(canonical, 765u);
+    }
+
+    TEST(MCTSTest, PrecomputedEvaluatorServesSearchesWithoutTheModel) {
+        NnmEvaluator<nnm::TicTacToeModel> model(shippedModel());
+        UniformEvaluator<TicTacToe> counting;
+        PrecomputedEvaluator table(counting);
+        EXPECT_EQ(table.size(), 4520u);
+        EXPECT_EQ(counting.calls, 4520u);
+        EXPECT_EQ(counting.largest_batch, PrecomputedEvaluator::BATCH_SIZE);
+
+        table.refresh(model);
+        for (TicTacToe game: {TicTacToe(), play({4}), play({0, 3, 1, 4}), play({8, 6, 2, 0, 4})}) {
+            ASSERT_TRUE(table.contains(game));
+            Evaluation stored = table.evaluate(game);
+            Evaluation direct = model.evaluate(game);
+            for (size_t a = 0; a < 9; ++a) {
+                EXPECT_NEAR(stored.policy[a], direct.policy[a], 1e-6);
+            }
+            EXPECT_NEAR(stored.value, direct.value, 1e-6);
+        }
+        TicTacToe finished = play({0, 3, 1, 4, 2});
+        EXPECT_FALSE(table.contains(finished));
+        EXPECT_THROW(table.evaluate(finished), std::invalid_argument);
+        EvaluationView view;
+        EXPECT_FALSE(table.lookup(finished, view));
+
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        std::vector<float> probs = mcts.search(play({0, 3, 1, 4}), table, 200);
+        EXPECT_EQ(std::max_element(probs.begin(), probs.end()) - probs.begin(), 2);
+        probs = mcts.searchParallel(TicTacToe(), table, 500, 4);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+    }
+
+    // Hands out the table's entries in place and counts the copies the search asks for instead.
+    class TableReader : public Evaluator<TicTacToe> {
+    public:
+        PrecomputedEvaluator &table;
+        std::atomic<size_t> copies = 0;
+
+        explicit TableReader(PrecomputedEvaluator &table) : table(table) {}
+
+        Evaluation evaluate(const TicTacToe &game) override {
+            ++copies;
+            return table.evaluate(game);
+        }
+
+        bool lookup(const TicTacToe &game, EvaluationView &view) const override {
+            return table.lookup(game, view);
+        }
+    };
+
+    TEST(MCTSTest, SearchesReadPrecomputedEntriesInPlace) {
+        NnmEvaluator<nnm::TicTacToeModel> model(shippedModel());
+        PrecomputedEvaluator table(model);
+
+        EvaluationView first, second;
+        ASSERT_TRUE(table.lookup(play({4}), first));
+        ASSERT_TRUE(table.lookup(play({4}), second));
+        EXPECT_EQ(first.policy, second.policy);
+        Evaluation copied = table.evaluate(play({4}));
+        EXPECT_EQ(std::vector<float>(first.policy, first.policy + 9), copied.policy);
+        EXPECT_EQ(first.value, copied.value);
+
+        TableReader reader(table);
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        std::vector<float> probs = mcts.search(play({0, 3, 1, 4}), reader, 200);
+        EXPECT_EQ(std::max_element(probs.begin(), probs.end()) - probs.begin(), 2);
+        mcts.setBatchSize(8);
+        mcts.search(TicTacToe(), reader, 500);
+        mcts.searchParallel(TicTacToe(), reader, 500, 4);
+
+        BatchScheduler<TicTacToe> scheduler(reader);
+        std::vector<float> scheduled;
+        scheduler.spawn(searchJob(scheduler, mcts, TicTacToe(), scheduled));
+        scheduler.run(1);
+        EXPECT_NEAR(std::accumulate(scheduled.begin(), scheduled.end(), 0.0f), 1.0f, 1e-5);
+        EXPECT_EQ(scheduler.evaluated(), 0u);
+        EXPECT_EQ(reader.copies, 0u);
+    }
+
+    // Puts all policy on the optimal moves and reports the exact value.
+    class PerfectEvaluator : public Evaluator<TicTacToe> {
+    public:
+        Evaluation evaluate(const TicTacToe &game) override {
+            const auto optimal = Solver::instance().optimalMoves(game);
+            std::vector<float> policy(optimal.begin(), optimal.end());
+            return {policy, static_cast<float>(Solver::instance().value(game))};
+        }
+    };
+
+    TEST(MCTSTest, SolverFindsExactValues) {
+        const Solver &solver = Solver::instance();
+        EXPECT_EQ(solver.value(TicTacToe()), 0);
+        // x to move with two in a row, o threatening nothing: a forced win.
+        EXPECT_EQ(solver.value(play({0, 3, 1, 4})), 1);
+        EXPECT_EQ(solver.optimalMoves(play({0, 3, 1, 4})), (std::array<uint8_t, 9>{0, 0, 1, 0, 0, 0, 0, 0, 0}));
+        // An o reply on an edge next to x's corner loses.
+        EXPECT_EQ(solver.value(play({0, 1})), 1);
+        // The centre is the only reply to a corner that holds the draw.
+        EXPECT_EQ(solver.optimalMoves(play({0})), (std::array<uint8_t, 9>{0, 0, 0, 0, 1, 0, 0, 0, 0}));
+        // Finished games, from the view of the player to move.
+        EXPECT_EQ(solver.value(play({0, 3, 1, 4, 2})), -1);
+        EXPECT_EQ(solver.value(play({0, 4, 8, 1, 7, 6, 2, 5, 3})), 0);
+
+        EXPECT_EQ(TicTacToe::runningPositions().size(), 4520u);
+        for (const TicTacToe &game: TicTacToe::runningPositions()) {
+            EXPECT_TRUE(game.isRunning());
+            const auto optimal = solver.optimalMoves(game);
+            EXPECT_GT(std::count(optimal.begin(), optimal.end(), 1), 0);
+        }
+    }
+
+    // A policy over fewer cells than the board has.
+    class ShortPolicyEvaluator : public Evaluator<TicTacToe> {
+    public:
+        Evaluation evaluate(const TicTacToe &) override {
+            return {std::vector<float>(3, 1.0f / 3), 0.0f};
+        }
+    };
+
+    TEST(MCTSTest, SolverGradesPolicies) {
+        PerfectEvaluator perfect;
+        PolicyScore score = Solver::instance().scorePolicy(perfect);
+        EXPECT_EQ(score.positions, 4520u);
+        EXPECT_FLOAT_EQ(score.move_accuracy, 1.0f);
+        EXPECT_FLOAT_EQ(score.optimal_mass, 1.0f);
+        EXPECT_FLOAT_EQ(score.value_error, 0.0f);
+
+        UniformEvaluator<TicTacToe> uniform;
+        score = Solver::instance().scorePolicy(uniform, 500);
+        EXPECT_EQ(uniform.largest_batch, 500u);
+        EXPECT_LT(score.move_accuracy, 1.0f);
+        EXPECT_LT(score.optimal_mass, 1.0f);
+        EXPECT_GT(score.optimal_mass, 0.0f);
+
+        NnmEvaluator<nnm::TicTacToeModel> model(shippedModel());
+        PolicyScore shipped = Solver::instance().scorePolicy(model);
+        EXPECT_GT(shipped.move_accuracy, score.move_accuracy);
+
+        ShortPolicyEvaluator short_policy;
+        EXPECT_THROW((void) Solver::instance().scorePolicy(short_policy), std::invalid_argument);
+        EXPECT_THROW(PrecomputedEvaluator{short_policy}, std::invalid_argument);
+    }
+
+    TEST(MCTSTest, SolverGateOnlyPromotesModelsAtLeastAsGoodAsTheBest) {
+        UniformEvaluator<TicTacToe> uniform;
+        NnmEvaluator<nnm::TicTacToeModel> model(shippedModel());
+        PerfectEvaluator perfect;
+        SolverGate gate(uniform);
+        const float uniform_accuracy = gate.best().move_accuracy;
+
+        PolicyScore score;
+        EXPECT_GT(gate.offer(model, score), 0.5f);
+        EXPECT_GT(score.move_accuracy, uniform_accuracy);
+        EXPECT_EQ(gate.best().move_accuracy, score.move_accuracy);
+
+        // A worse model is measured against the promoted one, not against itself.
+        const float shipped_accuracy = score.move_accuracy;
+        EXPECT_LT(gate.offer(uniform, score), 0.5f);
+        EXPECT_EQ(score.move_accuracy, uniform_accuracy);
+        EXPECT_EQ(gate.best().move_accuracy, shipped_accuracy);
+
+        EXPECT_GT(gate.offer(perfect, score), 0.5f);
+        EXPECT_FLOAT_EQ(gate.best().move_accuracy, 1.0f);
+        EXPECT_LT(gate.offer(model, score), 0.5f);
+        EXPECT_FLOAT_EQ(gate.best().move_accuracy, 1.0f);
+    }
+
+    // Players take one or two stones in turn and whoever takes the last one wins, so leaving a
+    // multiple of three is winning. Small enough to check the search on a game other than TicTacToe.
+    struct Subtraction {
+        static constexpr size_t ACTION_SIZE = 2;
+        static constexpr size_t MAX_GAME_LENGTH = 10;
+        static constexpr size_t PLANES = 1;
+        static constexpr size_t HEIGHT = 1;
+        static constexpr size_t WIDTH = 1;
+
+        uint8_t stones = 10;
+
+        [[nodiscard]] std::array<uint8_t, ACTION_SIZE> getLegalMoves() const {
+            return {stones >= 1, stones >= 2};
+        }
+
+        [[nodiscard]] int CountLegalMoves() const {
+            return std::min<int>(stones, 2);
+        }
+
+        void makeMove(uint8_t move) {
+            stones -= move + 1;
+        }
+
+        void encode(float *planes) const {
+            planes[0] = stones;
+        }
+
+        [[nodiscard]] nnm::Tensor4D getEncodedState() const {
+            nnm::Tensor4D state(1, 1, 1, 1);
+            encode(state.getData().data());
+            return state;
+        }
+
+        [[nodiscard]] std::pair<float, bool> getValueAndTerminated() const {
+            return {stones == 0 ? 1.0f : 0.0f, stones == 0};
+        }
+
+        [[nodiscard]] bool isRunning() const {
+            return stones > 0;
+        }
+
+        [[nodiscard]] uint64_t getKey() const {
+            return stones;
+        }
+
+        bool operator==(const Subtraction &) const = default;
+    };
+
+    static_assert(Game<Subtraction> && !SymmetricGame<Subtraction>);
+
+    TEST(MCTSTest, SearchRunsOnAnyGame) {
+        MCTSLearn<Subtraction> mcts(0.0f, 0.3f);
+        UniformEvaluator<Subtraction> evaluator;
+        EvaluationCache<Subtraction> cache(64);
+        evaluator.setCache(&cache);
+        mcts.setBatchSize(4);
+
+        // From ten stones, taking one leaves nine.
+        std::vector<float> probs = mcts.search(Subtraction{}, evaluator, 2000);
+        ASSERT_EQ(probs.size(), Subtraction::ACTION_SIZE);
+        EXPECT_GT(probs[0], probs[1]);
+        // From eight, taking two leaves six.
+        probs = mcts.searchParallel(Subtraction{8}, evaluator, 2000, 2);
+        EXPECT_GT(probs[1], probs[0]);
+        // Positions are shared whatever the move order and across searches, so each running position
+        // was evaluated once.
+        EXPECT_LE(cache.misses(), 10u);
+    }
+
+    TEST(MCTSTest, UltimateTicTacToePerftMatchesKnownCounts) {
+        const std::array<uint64_t, 6> expected = {81, 720, 6336, 55080, 473256, 4020960};
+        for (size_t depth = 1; depth <= expected.size(); ++depth) {
+            EXPECT_EQ(UltimateTicTacToe::perft(UltimateTicTacToe(), static_cast<int>(depth)), expected[depth - 1]);
+        }
+    }
+
+    TEST(MCTSTest, UltimateTicTacToeClosesWonSubBoards) {
+        UltimateTicTacToe game;
+        game.makeMove(0);
+        EXPECT_EQ(game.activeSubBoard(), 0);
+        EXPECT_EQ(game.CountLegalMoves(), 8);
+        // x takes the top row of sub-board 0, o sending x back there by playing cell 0 elsewhere.
+        for (uint8_t move: {4, 37, 9, 1, 13, 38, 18, 2}) {
+            game.makeMove(move);
+        }
+        EXPECT_EQ(game.wonSubBoards(0), 1);
+        EXPECT_TRUE(game.isRunning());
+        for (uint8_t move: {22, 39, 27}) {
+            game.makeMove(move);
+        }
+        // Sent to the closed sub-board 0, x may play in any open one.
+        EXPECT_EQ(game.activeSubBoard(), UltimateTicTacToe::ANY_SUB_BOARD);
+        EXPECT_EQ(game.CountLegalMoves(), 81 - 12 - 5);
+        const auto legal_moves = game.getLegalMoves();
+        EXPECT_EQ(std::count(legal_moves.begin(), legal_moves.end(), 1), game.CountLegalMoves());
+        EXPECT_EQ(legal_moves[3], 0);
+
+        nnm::Tensor4D planes = game.getEncodedState();
+        ASSERT_EQ(planes.getChannels(), UltimateTicTacToe::PLANES);
+        auto planeSum = [&](size_t plane) {
+            auto begin = planes.getData().begin() + plane * 81;
+            return std::accumulate(begin, begin + 81, 0.0f);
+        };
+        EXPECT_EQ(planeSum(0), 6.0f);
+        EXPECT_EQ(planeSum(1), 6.0f);
+        EXPECT_EQ(planeSum(2), 64.0f);
+        EXPECT_EQ(planeSum(3), 9.0f);
+        EXPECT_EQ(planeSum(4), 0.0f);
+        // Sub-board 0 is the top-left 3x3 block, its cell 1 the second column.
+        EXPECT_EQ(planes(0, 0, 0, 1), 1.0f);
+        EXPECT_EQ(planes(0, 3, 2, 2), 1.0f);
+    }
+
+    TEST(MCTSTest, UltimateTicTacToeRandomGamesEnd) {
+        std::mt19937 gen(11);
+        for (int game_index = 0; game_index < 200; ++game_index) {
+            UltimateTicTacToe game;
+            size_t moves = 0;
+            while (game.isRunning()) {
+                const auto legal_moves = game.getLegalMoves();
+                std::vector<uint8_t> choices;
+                for (uint8_t move = 0; move < UltimateTicTacToe::ACTION_SIZE; ++move) {
+                    if (legal_moves[move]) {
+                        choices.push_back(move);
+                    }
+                }
+                ASSERT_FALSE(choices.empty());
+                game.makeMove(choices[gen() % choices.size()]);
+                ++moves;
+            }
+            EXPECT_LE(moves, UltimateTicTacToe::MAX_GAME_LENGTH);
+            EXPECT_EQ(game.CountLegalMoves(), 0);
+            auto [value, terminated] = game.getValueAndTerminated();
+            EXPECT_TRUE(terminated);
+            EXPECT_TRUE(value == 0.0f || value == 1.0f);
+        }
+    }
+
+    TEST(MCTSTest, SearchRunsOnUltimateTicTacToe) {
+        MCTSLearn<UltimateTicTacToe> mcts(0.25f, 0.3f);
+        UniformEvaluator<UltimateTicTacToe> evaluator;
+        mcts.setBatchSize(8);
+        UltimateTicTacToe game;
+        game.makeMove(40);
+        std::vector<float> probs = mcts.search(game, evaluator, 300);
+        ASSERT_EQ(probs.size(), UltimateTicTacToe::ACTION_SIZE);
+        EXPECT_NEAR(std::accumulate(probs.begin(), probs.end(), 0.0f), 1.0f, 1e-5);
+        const auto legal_moves = game.getLegalMoves();
+        for (size_t move = 0; move < probs.size(); ++move) {
+            if (!legal_moves[move]) {
+                EXPECT_EQ(probs[move], 0.0f);
+            }
+        }
+    }
+
+    TEST(MCTSTest, EncodeBatchWritesEveryPlaneInPlace) {
+        std::mt19937 gen(5);
+        std::vector<TicTacToe> boards;
+        std::vector<UltimateTicTacToe> ultimates;
+        for (int game_index = 0; game_index < 40; ++game_index) {
+            TicTacToe board;
+            UltimateTicTacToe ultimate;
+            for (int ply = 0; ply < game_index % 9 && board.isRunning(); ++ply) {
+                const auto legal_moves = board.getLegalMoves();
+                uint8_t move;
+                do {
+                    move = static_cast<uint8_t>(gen() % 9);
+                } while (!legal_moves[move]);
+                board.makeMove(move);
+            }
+            for (int ply = 0; ply < game_index * 2 && ultimate.isRunning(); ++ply) {
+                const auto legal_moves = ultimate.getLegalMoves();
+                uint8_t move;
+                do {
+                    move = static_cast<uint8_t>(gen() % UltimateTicTacToe::ACTION_SIZE);
+                } while (!legal_moves[move]);
+                ultimate.makeMove(move);
+            }
+            boards.push_back(board);
+            ultimates.push_back(ultimate);
+        }
+
+        // Buffers start out as garbage, so every value has to be written.
+        std::vector<float> batch(boards.size() * ENCODED_SIZE<TicTacToe>, -7.0f);
+        encodeBatch(boards.data(), boards.size(), batch.data());
+        for (size_t i = 0; i < boards.size(); ++i) {
+            const nnm::Tensor4D encoded = boards[i].getEncodedState();
+            const std::vector<float> &single = encoded.getData();
+            ASSERT_TRUE(std::equal(single.begin(), single.end(), batch.begin() + i * ENCODED_SIZE<TicTacToe>));
+            const auto legal_moves = boards[i].getLegalMoves();
+            for (size_t cell = 0; cell < 9; ++cell) {
+                const size_t offset = i * ENCODED_SIZE<TicTacToe> + cell;
+                EXPECT_EQ(batch[offset] + batch[offset + 9] + batch[offset + 18], 1.0f);
+                EXPECT_EQ(batch[offset + 18], legal_moves[cell] ? 1.0f : 0.0f);
+            }
+        }
+
+        std::vector<float> ultimate_batch(ultimates.size() * ENCODED_SIZE<UltimateTicTacToe>, -7.0f);
+        encodeBatch(ultimates.data(), ultimates.size(), ultimate_batch.data());
+        for (size_t i = 0; i < ultimates.size(); ++i) {
+            const float *planes = ultimate_batch.data() + i * ENCODED_SIZE<UltimateTicTacToe>;
+            const auto legal_moves = ultimates[i].getLegalMoves();
+            for (size_t action = 0; action < UltimateTicTacToe::ACTION_SIZE; ++action) {
+                const size_t board = action / 9;
+                const size_t cell = action % 9;
+                const size_t square = (board / 3 * 3 + cell / 3) * 9 + board % 3 * 3 + cell % 3;
+                EXPECT_EQ(planes[2 * 81 + square], legal_moves[action] ? 1.0f : 0.0f);
+                EXPECT_LE(planes[square] + planes[81 + square], 1.0f);
+            }
+            for (size_t value = 0; value < ENCODED_SIZE<UltimateTicTacToe>; ++value) {
+                EXPECT_TRUE(planes[value] == 0.0f || planes[value] == 1.0f);
+            }
+        }
+    }
+
+    TEST(MCTSTest, SchedulerBatchesLeavesAcrossSearches) {
+        MCTSLearn<TicTacToe> mcts(0.0f, 0.3f);
+        mcts.setBatchSize(4);
+        mcts.setSymmetries(false);
+        UniformEvaluator<TicTacToe> evaluator;
+        BatchScheduler<TicTacToe> scheduler(evaluator, 64);
+
+        std::vector<TicTacToe> games;
+        for (uint8_t i = 0; i < 36; ++i) {
+            games.push_back(play({static_cast<uint8_t>(i % 9), static_cast<uint8_t>((i % 9 + 1 + i / 9) % 9)}));
+        }
+        std::vector<std::vector<float>> results(games.size());
+        for (size_t i = 0; i < games.size(); ++i) {
+            scheduler.spawn(searchJob(scheduler, mcts, games[i], results[i]));
+        }
+        scheduler.run(4);
+
+        // Each search asks for at most 4 leaves at a time; together they fill the 64 wide batches.
+        EXPECT_EQ(evaluator.largest_batch, 64u);
+        EXPECT_EQ(evaluator.calls.load(), scheduler.evaluated());
+        EXPECT_LT(scheduler.forwards() * 4, scheduler.evaluated());
+        // Batching across searches does not change what each search finds.
+        UniformEvaluator<TicTacToe> serial;
+        for (size_t i = 0; i < games.size(); ++i) {
+            EXPECT_EQ(results[i], mcts.search(games[i], serial, 200));
+        }
+
+        scheduler.spawn(failingJob(scheduler));
+        EXPECT_THROW(scheduler.run(1), std::runtime_error);
+    }
+
+    // Subtraction with every position on one key, as colliding Zobrist keys would leave them.
+    struct CollidingSubtraction : Subtraction {
+        [[nodiscard]] uint64_t getKey() const {
+            return 0;
+        }
+    };
+
+    class StonesEvaluator : public Evaluator<CollidingSubtraction> {
+    public:
+        Evaluation evaluate(const CollidingSubtraction &game) override {
+            return {{0.5f, 0.5f}, static_cast<float>(game.stones)};
+        }
+    };
+
+    BatchScheduler<CollidingSubtraction>::Task evaluateJob(BatchScheduler<CollidingSubtraction> &scheduler,
+                                                            std::vector<CollidingSubtraction> positions,
+                                                            std::vector<Evaluation> &result) {
+        result = co_await scheduler.evaluate(positions);
+    }
+
+    TEST(MCTSTest, SchedulerTellsPositionsWithOneKeyApart) {
+        StonesEvaluator evaluator;
+        BatchScheduler<CollidingSubtraction> scheduler(evaluator);
+        std::vector<Evaluation> first, second;
+        scheduler.spawn(evaluateJob(scheduler, {CollidingSubtraction{{7}}, CollidingSubtraction{{3}}}, first));
+        scheduler.spawn(evaluateJob(scheduler, {CollidingSubtraction{{3}}}, second));
+        scheduler.run(2);
+
+        ASSERT_EQ(first.size(), 2u);
+        ASSERT_EQ(second.size(), 1u);
+        EXPECT_EQ(first[0].value, 7.0f);
+        EXPECT_EQ(first[1].value, 3.0f);
+        EXPECT_EQ(second[0].value, 3.0f);
+        // The position both jobs asked for was still evaluated once.
+        EXPECT_EQ(scheduler.evaluated(), 2u);
+    }
+
+} // namespace
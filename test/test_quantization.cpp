@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include "Quantization.h"
+#include "LinearLayer.h"
+#include "ConvolutionalLayer.h"
+#include "TicTacToeModel.h"
+#include "RandomTensor.h"
+#include <random>
+#include <cmath>
+
+namespace nnm {
+
+    class QuantizationTest : public ::testing::Test {
+    protected:
+        // Random legal-looking boards in the model's (empty, player, opponent) one-hot encoding.
+        static std::vector<Tensor4D> random_boards(size_t count, unsigned seed) {
+            std::mt19937 gen(seed);
+            std::uniform_int_distribution<int> cell(0, 2);
+            std::vector<Tensor4D> boards;
+            for (size_t b = 0; b < count; ++b) {
+                Tensor4D board(1, 3, 3, 3);
+                for (size_t h = 0; h < 3; ++h) {
+                    for (size_t w = 0; w < 3; ++w) {
+                        board(0, cell(gen), h, w) = 1.0f;
+                    }
+                }
+                boards.push_back(board);
+            }
+            return boards;
+        }
+    };
+
+    TEST_F(QuantizationTest, QuantizeRowsMatchesScalarRounding) {
+        const size_t M = 3, K = 70;
+        Tensor4D x = random_tensor(1, 1, M, K, 1, -2.0f, 5.0f);
+        auto q = quant::ActivationQuant::fromRange(-2.0f, 5.0f);
+        std::vector<uint8_t> out(M * quant::padded(K), 0xff);
+        quant::quantizeRows(x.getData().data(), M, K, q, out.data());
+
+        for (size_t m = 0; m < M; ++m) {
+            for (size_t k = 0; k < quant::padded(K); ++k) {
+                int expected = 0;
+                if (k < K) {
+                    expected = static_cast<int>(std::nearbyint(x.getData()[m * K + k] / q.scale)) + q.zero_point;
+                    expected = std::clamp(expected, 0, quant::ACTIVATION_MAX);
+                }
+                EXPECT_NEAR(out[m * quant::padded(K) + k], expected, 1) << m << "," << k;
+            }
+        }
+    }
+
+    TEST_F(QuantizationTest, QuantizeRowsSaturatesOutsideCalibratedRange) {
+        // 40 values, so both the vector loop and the scalar tail see every case.
+        const size_t K = 40;
+        auto q = quant::ActivationQuant::fromRange(-2.0f, 5.0f);
+        const std::vector<float> cases = {1e12f, 3e9f, 6.0f, -1e12f, -3e9f, -3.0f, INFINITY, -INFINITY};
+        std::vector<float> x(K);
+        for (size_t k = 0; k < K; ++k) {
+            x[k] = cases[k % cases.size()];
+        }
+        std::vector<uint8_t> out(quant::padded(K));
+        quant::quantizeRows(x.data(), 1, K, q, out.data());
+
+        for (size_t k = 0; k < K; ++k) {
+            EXPECT_EQ(out[k], x[k] > 0.0f ? quant::ACTIVATION_MAX : 0) << k;
+        }
+    }
+
+    TEST_F(QuantizationTest, IntegerGemmMatchesDequantizedReference) {
+        const size_t M = 5, N = 7, K = 45;
+        Tensor4D a = random_tensor(1, 1, M, K, 2, 0.0f, 3.0f);
+        Tensor4D w = random_tensor(1, 1, N, K, 3, -1.0f, 1.0f);
+        Tensor4D bias = random_tensor(1, 1, 1, N, 4, -1.0f, 1.0f);
+
+        quant::QuantizedWeights qw(PackedTensor(w, DType::F32), N, K);
+        auto q = quant::ActivationQuant::fromRange(0.0f, 3.0f);
+        std::vector<uint8_t> qa(M * qw.k_padded);
+        quant::quantizeRows(a.getData().data(), M, K, q, qa.data());
+
+        std::vector<float> c(M * N);
+        quant::gemm_u8s8(qa.data(), M, qw, q, bias.getData().data(), c.data(), N, 1);
+
+        for (size_t m = 0; m < M; ++m) {
+            for (size_t n = 0; n < N; ++n) {
+                double exact = bias.getData()[n], dequantized = bias.getData()[n];
+                for (size_t k = 0; k < K; ++k) {
+                    exact += a.getData()[m * K + k] * w.getData()[n * K + k];
+                    dequantized += (static_cast<int>(qa[m * qw.k_padded + k]) - q.zero_point) * q.scale *
+                                   qw.data[n * qw.k_padded + k] * qw.scales[n];
+                }
+                EXPECT_NEAR(c[m * N + n], dequantized, 1e-4);
+                EXPECT_NEAR(c[m * N + n], exact, 0.1);
+            }
+        }
+    }
+
+    TEST_F(QuantizationTest, LayersRequireCalibrationAndCanSwitchBack) {
+        ConvolutionalLayer conv(3, 8, 3, 1, 1);
+        Tensor4D x = random_tensor(2, 3, 5, 5, 5, -1.0f, 1.0f);
+        EXPECT_THROW(conv.use_int8(true), std::invalid_argument);
+
+        conv.calibrate(true);
+        Tensor4D reference = conv.forward(x);
+        conv.calibrate(false);
+
+        conv.use_int8(true);
+        Tensor4D quantized = conv.forward(x);
+        float worst = 0.0f;
+        for (size_t i = 0; i < reference.getData().size(); ++i) {
+            worst = std::max(worst, std::abs(reference.getData()[i] - quantized.getData()[i]));
+        }
+        EXPECT_GT(worst, 0.0f);
+        EXPECT_LT(worst, 0.05f);
+
+        conv.use_int8(false);
+        EXPECT_TRUE(conv.forward(x) == reference);
+    }
+
+    TEST_F(QuantizationTest, QuantizeModelReportsSmallDelta) {
+        TicTacToeModel model(std::string(NNM_MODELS_DIR) + "/tictactoe.nnmw");
+        std::vector<Tensor4D> boards = random_boards(64, 6);
+
+        quant::QuantizationReport report = quant::quantize_model(model, boards);
+
+        EXPECT_EQ(report.samples, boards.size());
+        EXPECT_LT(report.mean_policy_error, 0.02f);
+        EXPECT_LT(report.max_value_error, 0.1f);
+        EXPECT_GE(report.policy_agreement, 0.9f);
+    }
+
+} // namespace nnm
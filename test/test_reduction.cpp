@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "Reduction.h"
+#include "Tensor4D.h"
+#include "RandomTensor.h"
+#include <cmath>
+#include <omp.h>
+
+namespace nnm {
+
+    class ReductionTest : public ::testing::Test {
+    protected:
+        // Straightforward double-precision reference over the same axes.
+        template<typename Combine>
+        static std::vector<double> reference(const Tensor4D &x, unsigned axes, double init, Combine combine) {
+            auto out_shape = reduction::reducedShape(x.shape(), axes);
+            std::vector<double> out(elementwise::numel(out_shape), init);
+            for (size_t n = 0; n < x.getBatchSize(); ++n) {
+                for (size_t c = 0; c < x.getChannels(); ++c) {
+                    for (size_t h = 0; h < x.getHeight(); ++h) {
+                        for (size_t w = 0; w < x.getWidth(); ++w) {
+                            size_t on = out_shape[0] == 1 ? 0 : n, oc = out_shape[1] == 1 ? 0 : c;
+                            size_t oh = out_shape[2] == 1 ? 0 : h, ow = out_shape[3] == 1 ? 0 : w;
+                            size_t o = ((on * out_shape[1] + oc) * out_shape[2] + oh) * out_shape[3] + ow;
+                            out[o] = combine(out[o], static_cast<double>(x(n, c, h, w)));
+                        }
+                    }
+                }
+            }
+            return out;
+        }
+    };
+
+    TEST_F(ReductionTest, SumAndMaxOverEveryAxisSubset) {
+        Tensor4D x = random_tensor(3, 5, 7, 11);
+        for (unsigned axes = 1; axes <= reduction::ALL; ++axes) {
+            Tensor4D sum = x.sum(axes);
+            Tensor4D max = x.max(axes);
+            auto expected_sum = reference(x, axes, 0.0, [](double a, double b) { return a + b; });
+            auto expected_max = reference(x, axes, -INFINITY, [](double a, double b) { return std::max(a, b); });
+            ASSERT_EQ(sum.getData().size(), expected_sum.size()) << "axes " << axes;
+            for (size_t i = 0; i < expected_sum.size(); ++i) {
+                EXPECT_NEAR(sum.getData()[i], expected_sum[i], 1e-3) << "axes " << axes << " output " << i;
+                EXPECT_FLOAT_EQ(max.getData()[i], static_cast<float>(expected_max[i])) << "axes " << axes;
+            }
+        }
+    }
+
+    TEST_F(ReductionTest, MeanOverBatchNormAxes) {
+        Tensor4D x = random_tensor(4, 16, 3, 3);
+        Tensor4D mean = x.mean(reduction::N | reduction::H | reduction::W);
+        auto expected = reference(x, reduction::N | reduction::H | reduction::W, 0.0,
+                                  [](double a, double b) { return a + b; });
+        ASSERT_EQ(mean.getChannels(), 16);
+        for (size_t c = 0; c < 16; ++c) {
+            EXPECT_NEAR(mean(0, c, 0, 0), expected[c] / 36.0, 1e-5);
+        }
+    }
+
+    TEST_F(ReductionTest, ArgmaxReturnsFirstMaximumInRowMajorOrder) {
+        Tensor4D x(2, 3, 2, 2, 0.0f);
+        x(0, 1, 1, 0) = 5.0f;
+        x(0, 2, 0, 1) = 5.0f;
+        x(1, 0, 0, 0) = -1.0f;
+        x(1, 2, 1, 1) = 2.0f;
+
+        auto per_sample = x.argmax(reduction::C | reduction::H | reduction::W);
+        ASSERT_EQ(per_sample.size(), 2u);
+        EXPECT_EQ(per_sample[0], 1u * 4 + 1 * 2 + 0);
+        EXPECT_EQ(per_sample[1], 2u * 4 + 1 * 2 + 1);
+
+        // Reducing a leading axis keeps the inner positions and returns the winning channel.
+        auto per_position = x.argmax(reduction::C);
+        ASSERT_EQ(per_position.size(), 8u);
+        EXPECT_EQ(per_position[0 * 4 + 2], 1u);
+        EXPECT_EQ(per_position[0 * 4 + 1], 2u);
+        EXPECT_EQ(per_position[1 * 4 + 0], 1u);
+        EXPECT_EQ(per_position[1 * 4 + 3], 2u);
+    }
+
+    TEST_F(ReductionTest, LogSumExpIsStableForLargeInputs) {
+        Tensor4D x = random_tensor(2, 9, 1, 1);
+        x(1, 4, 0, 0) = 1000.0f;
+        Tensor4D lse = x.logsumexp(reduction::C);
+        for (size_t n = 0; n < 2; ++n) {
+            double m = -INFINITY;
+            for (size_t c = 0; c < 9; ++c) m = std::max(m, static_cast<double>(x(n, c, 0, 0)));
+            double s = 0.0;
+            for (size_t c = 0; c < 9; ++c) s += std::exp(x(n, c, 0, 0) - m);
+            EXPECT_NEAR(lse(n, 0, 0, 0), m + std::log(s), 1e-4);
+        }
+
+        Tensor4D transposed = random_tensor(6, 20, 1, 1);
+        Tensor4D over_batch = transposed.logsumexp(reduction::N);
+        for (size_t c = 0; c < 20; ++c) {
+            double s = 0.0;
+            for (size_t n = 0; n < 6; ++n) s += std::exp(static_cast<double>(transposed(n, c, 0, 0)));
+            EXPECT_NEAR(over_batch(0, c, 0, 0), std::log(s), 1e-4);
+        }
+    }
+
+    TEST_F(ReductionTest, LargeSumIsAccurate) {
+        // 2^22 copies of 0.1f: a naive float accumulation drifts by several percent.
+        Tensor4D x(1, 1, 1 << 11, 1 << 11, 0.1f);
+        EXPECT_NEAR(x.sum(), 0.1 * (1 << 22), 0.1 * (1 << 22) * 1e-5);
+    }
+
+    TEST_F(ReductionTest, DeterministicModeIgnoresThreadCount) {
+        Tensor4D x = random_tensor(1, 2, 512, 513, 11);
+        reduction::Options deterministic{true};
+        int threads = omp_get_max_threads();
+
+        omp_set_num_threads(1);
+        Tensor4D single = x.sum(reduction::H | reduction::W, deterministic);
+        omp_set_num_threads(4);
+        Tensor4D multi = x.sum(reduction::H | reduction::W, deterministic);
+        omp_set_num_threads(threads);
+
+        EXPECT_EQ(single.getData(), multi.getData());
+    }
+
+} // namespace nnm
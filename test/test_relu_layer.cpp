@@ -193,4 +193,16 @@ namespace nnm {
         }
     }
 
+    TEST_F(ReLULayerTest, RvalueForwardReusesBuffer) {
+        Tensor4D x = generate_random_tensor(2, 3, 4, 5, -9, 9);
+        Tensor4D reference = x;
+        const float *buffer = x.getData().data();
+
+        ReLULayer layer;
+        Tensor4D result = layer.forward(std::move(x));
+
+        EXPECT_EQ(result.getData().data(), buffer);
+        EXPECT_TRUE(result == layer.forward(reference));
+    }
+
 } // namespace nnm
\ No newline at end of file
@@ -437,3 +437,45 @@ TEST_F(Tensor4DTest, ComprehensivePadding) {
     EXPECT_FLOAT_EQ(padded(3, 3, 5, 5), 0.0f);
 }
 
+TEST_F(Tensor4DTest, InPlaceOperations) {
+    nnm::Tensor4D a(1, 2, 3, 3, 2.0f);
+    nnm::Tensor4D b(1, 2, 3, 3, 0.5f);
+    const float *buffer = a.getData().data();
+
+    a.add_(b).mul_(b).mul_(4.0f);
+    EXPECT_EQ(a.getData().data(), buffer);
+    EXPECT_FLOAT_EQ(a(0, 1, 2, 2), 5.0f);
+
+    a(0, 0, 0, 0) = -3.0f;
+    a.relu_();
+    EXPECT_FLOAT_EQ(a(0, 0, 0, 0), 0.0f);
+    EXPECT_FLOAT_EQ(a(0, 0, 0, 1), 5.0f);
+
+    a.clamp_(1.0f, 2.0f);
+    EXPECT_FLOAT_EQ(a(0, 0, 0, 0), 1.0f);
+    EXPECT_FLOAT_EQ(a(0, 1, 1, 1), 2.0f);
+
+    a.tanh_();
+    EXPECT_NEAR(a(0, 0, 0, 0), std::tanh(1.0f), 1e-6f);
+
+    nnm::Tensor4D wrong_shape(1, 3, 3, 3);
+    EXPECT_THROW(a.add_(wrong_shape), std::invalid_argument);
+}
+
+TEST_F(Tensor4DTest, RvalueOperatorsReuseLeftBuffer) {
+    nnm::Tensor4D a(2, 3, 4, 5, 1.5f);
+    nnm::Tensor4D b(2, 3, 4, 5, 0.5f);
+    const float *buffer = a.getData().data();
+
+    nnm::Tensor4D sum = std::move(a) + b;
+    EXPECT_EQ(sum.getData().data(), buffer);
+    EXPECT_FLOAT_EQ(sum(1, 2, 3, 4), 2.0f);
+
+    nnm::Tensor4D scaled = (std::move(sum) - b) * 3.0f;
+    EXPECT_EQ(scaled.getData().data(), buffer);
+    EXPECT_FLOAT_EQ(scaled(0, 0, 0, 0), 4.5f);
+
+    nnm::Tensor4D copy = b + b;
+    EXPECT_NE(copy.getData().data(), b.getData().data());
+    EXPECT_FLOAT_EQ(b(0, 0, 0, 0), 0.5f);
+}
@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include "WeightFile.h"
+#include "FoldBatchNorm.h"
+#include "ResNet.h"
+#include "TicTacToeModel.h"
+#include "RandomTensor.h"
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+namespace nnm {
+
+    class WeightFileTest : public ::testing::Test {
+    protected:
+        std::string path = ::testing::TempDir() + "nnm_weight_file_test.nnmw";
+
+        void TearDown() override {
+            std::remove(path.c_str());
+        }
+
+    };
+
+    TEST_F(WeightFileTest, RoundTripKeepsNamesShapesAndAlignment) {
+        Tensor4D a = random_tensor(2, 3, 4, 5, 1);
+        Tensor4D b = random_tensor(1, 7, 1, 1, 2);
+        WeightFileWriter writer;
+        writer.add("layer.weight", a, DType::F16);
+        writer.add("layer.bias", b);
+        writer.write(path);
+
+        WeightFile file = WeightFile::open(path);
+        ASSERT_EQ(file.names(), (std::vector<std::string>{"layer.weight", "layer.bias"}));
+        EXPECT_EQ(file.get("layer.weight").dtype(), DType::F16);
+        EXPECT_EQ(file.get("layer.weight").shape(), a.shape());
+        EXPECT_TRUE(file.get("layer.bias").toTensor() == b);
+        EXPECT_TRUE(file.get("layer.weight").toTensor() == PackedTensor(a, DType::F16).toTensor());
+        for (const auto &name: file.names()) {
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(file.get(name).data()) % 64, 0u) << name;
+        }
+        EXPECT_THROW((void) file.get("missing"), std::invalid_argument);
+        EXPECT_THROW(writer.add("layer.bias", b), std::invalid_argument);
+    }
+
+    TEST_F(WeightFileTest, ResNetRoundTripUsesTorchNames) {
+        ResNet source(2, 8, 9, 3, 3);
+        save_weights(source, path);
+
+        WeightFile file = WeightFile::open(path);
+        EXPECT_TRUE(file.contains("startBlock.0.weight"));
+        EXPECT_TRUE(file.contains("backBone.1.bn2.running_var"));
+        EXPECT_TRUE(file.contains("valueHead.4.bias"));
+
+        ResNet loaded(2, 8, 9, 3, 3);
+        loaded.load(file);
+
+        Tensor4D x = random_tensor(1, 3, 3, 3, 3);
+        auto [policy, value] = source.forward(x);
+        auto [loaded_policy, loaded_value] = loaded.forward(x);
+        EXPECT_TRUE(policy == loaded_policy);
+        EXPECT_TRUE(value == loaded_value);
+    }
+
+    TEST_F(WeightFileTest, LoadedLayersUseMappedMemory) {
+        ConvolutionalLayer source(3, 8, 3, 1, 1);
+        source.convert_weights(DType::F16);
+        save_weights(source, path);
+
+        ConvolutionalLayer conv(3, 8, 3, 1, 1);
+        {
+            WeightFile file = WeightFile::open(path);
+            load_weights(conv, file);
+            EXPECT_EQ(conv.get_packed_weights().data(), file.get("weight").data());
+            EXPECT_EQ(conv.get_packed_weights().dtype(), DType::F16);
+        }
+        // The layer keeps the mapping alive after the WeightFile handle is gone.
+        Tensor4D x = random_tensor(1, 3, 4, 4, 4);
+        EXPECT_TRUE(conv.forward(x) == source.forward(x));
+    }
+
+    TEST_F(WeightFileTest, RejectsMismatchedOrCorruptFiles) {
+        ResNet small(1, 8, 9, 3, 3);
+        save_weights(small, path);
+        ResNet wide(1, 16, 9, 3, 3);
+        EXPECT_THROW(wide.load(WeightFile::open(path)), std::invalid_argument);
+
+        {
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.write("XXXX", 4);
+        }
+        EXPECT_THROW(WeightFile::open(path), std::runtime_error);
+        EXPECT_THROW(WeightFile::open(path + ".missing"), std::runtime_error);
+
+        // Entries whose size or end would wrap around 64 bits instead of pointing past the file.
+        auto corrupt_first_entry = [this, &small](size_t field_offset, const std::vector<uint64_t> &values) {
+            save_weights(small, path);
+            std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+            f.seekp(static_cast<std::streamoff>(sizeof(weight_file::Header) + field_offset));
+            f.write(reinterpret_cast<const char *>(values.data()),
+                    static_cast<std::streamsize>(values.size() * sizeof(uint64_t)));
+        };
+        corrupt_first_entry(offsetof(weight_file::Entry, dims), {uint64_t(1) << 62, 1, 1, 4});
+        EXPECT_THROW(WeightFile::open(path), std::runtime_error);
+        corrupt_first_entry(offsetof(weight_file::Entry, offset), {~uint64_t(0) - 63});
+        EXPECT_THROW(WeightFile::open(path), std::runtime_error);
+        save_weights(small, path);
+        EXPECT_NO_THROW(WeightFile::open(path));
+    }
+
+    TEST_F(WeightFileTest, TicTacToeModelLoadsShippedWeights) {
+        TicTacToeModel model(std::string(NNM_MODELS_DIR) + "/tictactoe.nnmw");
+        Tensor4D x(1, 3, 3, 3, 0.5f);
+        auto [policy, value] = model.forward(x);
+
+        std::vector<float> expected = {0.934448f, 2.08166e-07f, 9.12151e-08f, 0.00175996f, 0.00119963f,
+                                       2.7242e-08f, 0.00644561f, 0.0524448f, 0.00370198f};
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_NEAR(policy(0, i, 0, 0), expected[i], 1e-5);
+        }
+        EXPECT_NEAR(value(0, 0, 0, 0), 0.77918f, 1e-5);
+    }
+
+    TEST_F(WeightFileTest, FoldedBatchNormKeepsModelOutputs) {
+        // The shipped batch norm is close to identity, so give it statistics that matter first.
+        WeightFile shipped = WeightFile::open(std::string(NNM_MODELS_DIR) + "/tictactoe.nnmw");
+        std::map<std::string, Tensor4D> state;
+        for (const std::string &name: shipped.names()) {
+            state.emplace(name, shipped.get(name).toTensor());
+        }
+        state.at("bn1.weight") = random_tensor(1, 16, 1, 1, 3);
+        state.at("bn1.bias") = random_tensor(1, 16, 1, 1, 4);
+        state.at("bn1.running_mean") = random_tensor(1, 16, 1, 1, 5);
+        state.at("bn1.running_var") = random_tensor(1, 16, 1, 1, 6);
+        for (float &var: state.at("bn1.running_var").getData()) {
+            var = 0.5f + var * var;
+        }
+
+        auto write = [&](const std::map<std::string, Tensor4D> &tensors, const std::string &file) {
+            WeightFileWriter writer;
+            for (const auto &[name, tensor]: tensors) {
+                writer.add(name, tensor);
+            }
+            writer.write(file);
+        };
+        const std::string folded_path = path + ".folded";
+        write(state, path);
+        std::map<std::string, Tensor4D> folded = state;
+        fold_batch_norm(folded, "conv1", "bn1");
+        write(folded, folded_path);
+
+        TicTacToeModel reference(path);
+        TicTacToeModel model(folded_path);
+        std::remove(folded_path.c_str());
+        for (unsigned seed = 0; seed < 8; ++seed) {
+            Tensor4D x = random_tensor(1, 3, 3, 3, 100 + seed);
+            auto [reference_policy, reference_value] = reference.forward(x);
+            auto [policy, value] = model.forward(x);
+            for (size_t i = 0; i < 9; ++i) {
+                EXPECT_NEAR(policy(0, i, 0, 0), reference_policy(0, i, 0, 0), 1e-5);
+            }
+            EXPECT_NEAR(value(0, 0, 0, 0), reference_value(0, 0, 0, 0), 1e-5);
+        }
+
+        // The batch norm left behind passes its input through unchanged.
+        BatchNorm2d bn(16);
+        bn.set_parameters(folded.at("bn1.weight"), folded.at("bn1.bias"), folded.at("bn1.running_mean"),
+                          folded.at("bn1.running_var"));
+        Tensor4D x = random_tensor(1, 16, 2, 2, 7);
+        EXPECT_TRUE(bn.forward(x) == x);
+        EXPECT_THROW(fold_batch_norm(folded, "conv1", "bn2"), std::invalid_argument);
+    }
+
+} // namespace nnm